@@ -2,10 +2,13 @@
 #define TOPION_HPP_
 
 //#define TOPION_DEBUG
+//#define TOPION_STATS
 
-#include <deque>
-#include <unordered_map>
+#include <vector>
 #include <functional>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
 #include <string>
 #include <sstream>
 #include <cstdlib>
@@ -13,11 +16,64 @@
 #include <cctype>
 #include <stdexcept>
 #include <limits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cerrno>
+#include <cfloat>
+#include <memory>
+#include <exception>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <list>
+#include <ostream>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+#endif
+#endif
+
+#if defined(__cpp_lib_memory_resource) && !defined(TOPION_NO_PMR)
+#define TOPION_USE_PMR
+#endif
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(TOPION_NO_MMAP)
+#define TOPION_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TOPION_USE_DIRENT
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
 
 #ifdef TOPION_DEBUG
 #include <iostream>
 #endif // TOPION_DEBUG
 
+#ifdef TOPION_STATS
+#include <chrono>
+#include <new>
+#endif // TOPION_STATS
+
+#if defined(__GNUC__)
+#define TOPION_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define TOPION_NOINLINE __declspec(noinline)
+#else
+#define TOPION_NOINLINE
+#endif
+
 class topion_definition_error: public std::invalid_argument {
 	using std::invalid_argument::invalid_argument;
 };
@@ -25,580 +81,4143 @@ class topion_parsing_error: public std::runtime_error {
 	using std::runtime_error::runtime_error;
 };
 
+struct Topion;
+
 namespace TopionUtil{
+#if __cplusplus >= 201703L
+	using string_view = std::string_view;
+#else
+	// A minimal substitute of std::string_view: a non-owning reference to characters
+	class string_view{
+	public:
+		using size_type = size_t;
+		using const_iterator = const char *;
+
+		constexpr string_view() : ptr(nullptr), len(0) {}
+		constexpr string_view(const char * s, size_t n) : ptr(s), len(n) {}
+		string_view(const char * s) : ptr(s), len(std::strlen(s)) {}
+		string_view(const std::string & s) : ptr(s.data()), len(s.length()) {}
+
+		constexpr const char * data() const{ return ptr; }
+		constexpr size_t size() const{ return len; }
+		constexpr size_t length() const{ return len; }
+		constexpr bool empty() const{ return len == 0; }
+		constexpr const char * begin() const{ return ptr; }
+		constexpr const char * end() const{ return ptr + len; }
+		constexpr const char & operator[](size_t p) const{ return ptr[p]; }
+
+		explicit operator std::string() const{ return std::string(ptr, len); }
+
+		int compare(string_view other) const{
+			int r = std::memcmp(ptr, other.ptr, std::min(len, other.len));
+			if(r != 0) return r;
+			return len < other.len ? -1 : (len > other.len ? 1 : 0);
+		}
+
+	private:
+		const char * ptr;
+		size_t len;
+	};
+
+	inline bool operator==(string_view a, string_view b){ return a.size() == b.size() && a.compare(b) == 0; }
+	inline bool operator!=(string_view a, string_view b){ return !(a == b); }
+	inline bool operator<(string_view a, string_view b){ return a.compare(b) < 0; }
+
+	inline std::ostream & operator<<(std::ostream & out, string_view s){
+		return out.write(s.data(), s.size());
+	}
+#endif
+
+#ifdef TOPION_USE_PMR
+	using MemoryResource = std::pmr::memory_resource;
+	using MonotonicArena = std::pmr::monotonic_buffer_resource;
+	template <class T>
+	using Allocator = std::pmr::polymorphic_allocator<T>;
+
+	inline MemoryResource * default_resource() noexcept{
+		return std::pmr::get_default_resource();
+	}
+#else
+	// A minimal substitute of std::pmr::memory_resource: the source of the memory of the buffers of a Topion
+	class MemoryResource{
+	public:
+		virtual ~MemoryResource(){}
+
+		void * allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)){
+			return do_allocate(bytes, alignment);
+		}
+
+		void deallocate(void * p, size_t bytes, size_t alignment = alignof(std::max_align_t)){
+			do_deallocate(p, bytes, alignment);
+		}
+
+		bool is_equal(const MemoryResource & other) const noexcept{
+			return do_is_equal(other);
+		}
+
+	private:
+		virtual void * do_allocate(size_t bytes, size_t alignment) = 0;
+		virtual void do_deallocate(void * p, size_t bytes, size_t alignment) = 0;
+		virtual bool do_is_equal(const MemoryResource & other) const noexcept = 0;
+	};
+
+	inline bool operator==(const MemoryResource & a, const MemoryResource & b) noexcept{
+		return &a == &b || a.is_equal(b);
+	}
+	inline bool operator!=(const MemoryResource & a, const MemoryResource & b) noexcept{ return !(a == b); }
+
+	class NewDeleteResource : public MemoryResource{
+		void * do_allocate(size_t bytes, size_t) override{
+			return ::operator new(bytes);
+		}
+
+		void do_deallocate(void * p, size_t, size_t) override{
+			::operator delete(p);
+		}
+
+		bool do_is_equal(const MemoryResource & other) const noexcept override{
+			return this == &other;
+		}
+	};
+
+	inline MemoryResource * default_resource() noexcept{
+		static NewDeleteResource resource;
+		return &resource;
+	}
+
+	// A minimal substitute of std::pmr::monotonic_buffer_resource: hands out memory from "buffer" and then from
+	// chunks of growing sizes, never frees anything on deallocate, and frees all the chunks at once on release
+	class MonotonicArena : public MemoryResource{
+	public:
+		MonotonicArena() : MonotonicArena(nullptr, 0) {}
+
+		MonotonicArena(void * buffer, size_t size) :
+			initial(static_cast<char *>(buffer)), initial_size(size), cur(initial), left(size), next_size(std::max<size_t>(size, 1024)), chunks(nullptr) {}
+
+		MonotonicArena(const MonotonicArena &) = delete;
+		MonotonicArena & operator=(const MonotonicArena &) = delete;
+
+		~MonotonicArena(){
+			release();
+		}
+
+		void release() noexcept{
+			while(chunks != nullptr){
+				Chunk * c = chunks;
+				chunks = c->previous;
+				::operator delete(c);
+			}
+			cur = initial;
+			left = initial_size;
+		}
+
+	private:
+		struct Chunk{
+			Chunk * previous;
+			std::max_align_t align;
+		};
+
+		void * do_allocate(size_t bytes, size_t alignment) override{
+			size_t pad = (alignment - reinterpret_cast<std::uintptr_t>(cur) % alignment) % alignment;
+			if(cur == nullptr || pad + bytes > left){
+				size_t size = std::max(next_size, bytes + alignment);
+				Chunk * c = static_cast<Chunk *>(::operator new(offsetof(Chunk, align) + size));
+				c->previous = chunks;
+				chunks = c;
+				cur = reinterpret_cast<char *>(&c->align);
+				left = size;
+				next_size = size * 2;
+				pad = (alignment - reinterpret_cast<std::uintptr_t>(cur) % alignment) % alignment;
+			}
+			void * p = cur + pad;
+			cur += pad + bytes;
+			left -= pad + bytes;
+			return p;
+		}
+
+		void do_deallocate(void *, size_t, size_t) override {}
+
+		bool do_is_equal(const MemoryResource & other) const noexcept override{
+			return this == &other;
+		}
+
+		char * initial;
+		size_t initial_size;
+		char * cur;
+		size_t left;
+		size_t next_size;
+		Chunk * chunks;
+	};
+
+	// A minimal substitute of std::pmr::polymorphic_allocator: allocates from a MemoryResource, kept by copies
+	// of a container but not by copy-constructed ones (which take the default resource), as the standard one
+	template <class T>
+	class Allocator{
+	public:
+		using value_type = T;
+
+		Allocator() noexcept : memory(default_resource()) {}
+		Allocator(MemoryResource * memory) noexcept : memory(memory) {}
+		template <class U>
+		Allocator(const Allocator<U> & other) noexcept : memory(other.resource()) {}
+
+		T * allocate(size_t n){
+			return static_cast<T *>(memory->allocate(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T * p, size_t n){
+			memory->deallocate(p, n * sizeof(T), alignof(T));
+		}
+
+		Allocator select_on_container_copy_construction() const{
+			return Allocator();
+		}
+
+		MemoryResource * resource() const noexcept{
+			return memory;
+		}
+
+	private:
+		MemoryResource * memory;
+	};
+
+	template <class T, class U>
+	bool operator==(const Allocator<T> & a, const Allocator<U> & b) noexcept{ return *a.resource() == *b.resource(); }
+	template <class T, class U>
+	bool operator!=(const Allocator<T> & a, const Allocator<U> & b) noexcept{ return !(a == b); }
+#endif // TOPION_USE_PMR
+
+	// A buffer of a Topion, allocated from the memory resource given to the constructor
+	template <class T>
+	using buffer_type = std::vector<T, Allocator<T>>;
+
+	// Frees the memory of a buffer (clear() keeps the capacity)
+	template <class T>
+	void free_buffer(buffer_type<T> & buffer){
+		buffer_type<T>(buffer.get_allocator()).swap(buffer);
+	}
+
+	// A converter is a function object called as "conv(T & target, const char * s, size_t len)", where the parameter
+	// [s, s + len) is not null-terminated in general. The signature of older versions, converter_type, is also accepted.
 	using converter_type = std::function<bool(void *, const std::string &)>;
 
-	template<class INTTYPE, class CONVFUNCTYPE>
-	bool signed_int_converter(INTTYPE * pi, const std::string & s, const CONVFUNCTYPE & conv_func){
-		char * ptr;
-		*pi = conv_func(s.c_str(), &ptr, 10);
-		for(;;){
-			if(*ptr == '\0'){
-				return true;
-			}else if(std::isspace(*ptr)){
-				++ptr;
-			}else{
-				return false;
+	// ------------------------------------------------------------
+	// Numbers: decimal only, independent of the locale.
+	// Spaces (" \t\n\v\f\r") around the number are allowed.
+	// ------------------------------------------------------------
+	inline bool is_space(char c){
+		return c == ' ' || (c >= '\t' && c <= '\r');
+	}
+
+	inline void trim_spaces(const char * & p, const char * & end){
+		while(p < end && is_space(*p)) ++p;
+		while(end > p && is_space(end[-1])) --end;
+	}
+
+	// Reads eight decimal digits at once in a 64-bit integer ("SWAR"), false if any of them is not a digit
+	inline bool eight_digits(const char * p, std::uint64_t & value){
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_X64) || defined(_M_IX86) || defined(_M_ARM64)
+		std::uint64_t v;
+		std::memcpy(&v, p, sizeof(v));
+		if(((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) != 0x3333333333333333ULL){
+			return false;
+		}
+		v -= 0x3030303030303030ULL;
+		v = (v * 10) + (v >> 8); // pairs of digits
+		v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) + (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+		value = v;
+		return true;
+#else
+		(void)p;
+		(void)value;
+		return false;
+#endif
+	}
+
+	template<class INTTYPE>
+	bool is_negative(INTTYPE v, std::true_type){
+		return v < 0;
+	}
+
+	template<class INTTYPE>
+	bool is_negative(INTTYPE, std::false_type){
+		return false;
+	}
+
+	// Fails if the number is out of [lowest, highest] (by default the range of INTTYPE, instead of saturating like strtol).
+	// The bound on the side of the sign limits the digits as they are read, so a number too large fails without reading all of them.
+	template<class INTTYPE>
+	bool integer_converter(INTTYPE * pi, const char * s, size_t len, INTTYPE lowest = std::numeric_limits<INTTYPE>::min(), INTTYPE highest = std::numeric_limits<INTTYPE>::max()){
+		using unsigned_type = typename std::make_unsigned<INTTYPE>::type;
+		const char * p = s;
+		const char * end = s + len;
+		trim_spaces(p, end);
+
+		bool negative = false;
+		if(p < end && (*p == '+' || *p == '-')){
+			negative = (*p == '-');
+			if(negative && !std::is_signed<INTTYPE>::value) return false;
+			++p;
+		}
+		if(p == end) return false;
+
+		// The largest absolute value: "highest", or -"lowest" for negative numbers (0 if the range has none of the sign)
+		std::integral_constant<bool, std::is_signed<INTTYPE>::value> signed_type;
+		unsigned_type limit;
+		if(!negative){
+			limit = is_negative(highest, signed_type) ? 0 : static_cast<unsigned_type>(highest);
+		}else{
+			limit = is_negative(lowest, signed_type) ? static_cast<unsigned_type>(-(lowest + 1)) + 1 : 0;
+		}
+		unsigned_type limit_div10 = limit / 10;
+		unsigned limit_mod10 = static_cast<unsigned>(limit % 10);
+		unsigned_type v = 0;
+		if(limit >= 99999999){
+			std::uint64_t chunk;
+			while(end - p >= 8 && eight_digits(p, chunk)){
+				if(v > (limit - chunk) / 100000000) return false;
+				v = static_cast<unsigned_type>(v * 100000000 + chunk);
+				p += 8;
 			}
 		}
+		for(; p < end; ++p){
+			unsigned d = static_cast<unsigned>(static_cast<unsigned char>(*p)) - '0';
+			if(d > 9) return false;
+			if(v > limit_div10 || (v == limit_div10 && d > limit_mod10)) return false;
+			v = static_cast<unsigned_type>(v * 10 + d);
+		}
+
+		INTTYPE value;
+		if(negative && v != 0){
+			value = static_cast<INTTYPE>(-static_cast<INTTYPE>(v - 1) - 1);
+		}else{
+			value = static_cast<INTTYPE>(v);
+		}
+		// The bound on the other side (e.g., "lowest" of a positive range)
+		if(value < lowest || value > highest) return false;
+		*pi = value;
+		return true;
+	}
+
+	// Floating-point numbers are computed in double as "digits * 10^exponent" or "digits / 10^-exponent" when the digits
+	// and the power of ten are both exactly representable, which rounds correctly ("Clinger's fast path").
+	// Otherwise they are parsed by strtod / strtof with the number rewritten without the decimal point.
+	template<class FLOATTYPE>
+	struct FloatingParsing;
+
+	template<>
+	struct FloatingParsing<double>{
+		static bool from_double(double d, double & v){
+			v = d;
+			return true;
+		}
+		static double parse(const char * s, char ** end){
+			return std::strtod(s, end);
+		}
+	};
+
+	template<>
+	struct FloatingParsing<float>{
+		// Rounding the correctly rounded double again to float is correct unless it is just halfway between two floats
+		// (all the results of the fast path are in the range of normal floats)
+		static bool from_double(double d, float & v){
+			std::uint64_t bits;
+			std::memcpy(&bits, &d, sizeof(bits));
+			const std::uint64_t extra_bits = (std::uint64_t(1) << (std::numeric_limits<double>::digits - std::numeric_limits<float>::digits)) - 1;
+			if((bits & extra_bits) == (extra_bits + 1) / 2) return false;
+			v = static_cast<float>(d);
+			return true;
+		}
+		static float parse(const char * s, char ** end){
+			return std::strtof(s, end);
+		}
+	};
+
+	inline double exact_power_of_ten(int e){
+		static const double p[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+		return p[e];
 	}
 
-	template<class INTTYPE, class CONVFUNCTYPE>
-	bool unsigned_int_converter(INTTYPE * pi, const std::string & s, const CONVFUNCTYPE & conv_func){
-		size_t start_except_spaces = 0;
-		for(; start_except_spaces < s.length(); ++start_except_spaces){
-			if(!(std::isspace(s[start_except_spaces]))) break;
+	// "inf", "infinity" or "nan" (case-insensitive)
+	inline bool equals_ignoring_case(const char * p, const char * end, const char * word){
+		for(; *word != '\0'; ++p, ++word){
+			if(p == end || std::tolower(static_cast<unsigned char>(*p)) != *word) return false;
 		}
-		if(s[start_except_spaces] == '-') return false;
+		return p == end;
+	}
 
-		char * ptr;
-		*pi = conv_func(s.c_str() + start_except_spaces, &ptr, 10);
-		for(;;){
-			if(*ptr == '\0'){
-				return true;
-			}else if(std::isspace(*ptr)){
-				++ptr;
+	// Fails if the number is too large for FLOATTYPE (instead of returning infinity like strtod)
+	template<class FLOATTYPE>
+	bool floating_converter(FLOATTYPE * pf, const char * s, size_t len){
+		using parsing = FloatingParsing<FLOATTYPE>;
+		const char * p = s;
+		const char * end = s + len;
+		trim_spaces(p, end);
+
+		bool negative = false;
+		if(p < end && (*p == '+' || *p == '-')){
+			negative = (*p == '-');
+			++p;
+		}
+		if(p < end && (*p == 'i' || *p == 'I' || *p == 'n' || *p == 'N')){
+			FLOATTYPE v;
+			if(equals_ignoring_case(p, end, "inf") || equals_ignoring_case(p, end, "infinity")){
+				v = std::numeric_limits<FLOATTYPE>::infinity();
+			}else if(equals_ignoring_case(p, end, "nan")){
+				v = std::numeric_limits<FLOATTYPE>::quiet_NaN();
 			}else{
 				return false;
 			}
+			*pf = negative ? -v : v;
+			return true;
+		}
+
+		// The number is "digits * 10^exponent", where "digits" keeps the first 19 significant digits
+		const char * digits_begin = p;
+		std::uint64_t digits = 0;
+		int num_digits = 0;
+		bool truncated = false; // nonzero digits after the first 19 are dropped
+		bool any_digit = false;
+		long long exponent = 0;
+		size_t num_fraction = 0;
+		for(bool fraction = false; p < end; ++p){
+			if(*p == '.' && !fraction){
+				fraction = true;
+				continue;
+			}
+			unsigned d = static_cast<unsigned>(static_cast<unsigned char>(*p)) - '0';
+			if(d > 9) break;
+			any_digit = true;
+			if(fraction) ++num_fraction;
+			if(num_digits < 19){
+				if(digits != 0 || d != 0){
+					digits = digits * 10 + d;
+					++num_digits;
+				}
+				if(fraction) --exponent;
+			}else{
+				if(!fraction) ++exponent;
+				if(d != 0) truncated = true;
+			}
+		}
+		if(!any_digit) return false;
+		const char * digits_end = p;
+
+		long long written_exponent = 0;
+		if(p < end && (*p == 'e' || *p == 'E')){
+			++p;
+			bool negative_exponent = false;
+			if(p < end && (*p == '+' || *p == '-')){
+				negative_exponent = (*p == '-');
+				++p;
+			}
+			if(p == end) return false;
+			for(; p < end; ++p){
+				unsigned d = static_cast<unsigned>(static_cast<unsigned char>(*p)) - '0';
+				if(d > 9) return false;
+				if(written_exponent < 100000000) written_exponent = written_exponent * 10 + d;
+			}
+			if(negative_exponent) written_exponent = -written_exponent;
+		}
+		if(p != end) return false;
+		exponent += written_exponent;
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+		const bool exact_arithmetic = true;
+#else
+		const bool exact_arithmetic = false; // intermediate results may be rounded twice
+#endif
+		FLOATTYPE v;
+		bool fast = false;
+		if(digits == 0 && !truncated){
+			v = 0;
+			fast = true;
+		}else if(exact_arithmetic && !truncated && digits <= (std::uint64_t(1) << std::numeric_limits<double>::digits) && exponent >= -22 && exponent <= 22){
+			double d = static_cast<double>(digits);
+			if(exponent < 0){
+				d /= exact_power_of_ten(static_cast<int>(-exponent));
+			}else{
+				d *= exact_power_of_ten(static_cast<int>(exponent));
+			}
+			fast = parsing::from_double(d, v);
+		}
+		if(!fast){
+			// "[digits]e[exponent]" without the decimal point, which is the only part of strtod depending on the locale
+			char local[128];
+			std::string heap;
+			size_t size = (digits_end - digits_begin) + 24;
+			char * buf = local;
+			if(size > sizeof(local)){
+				heap.resize(size);
+				buf = &heap[0];
+			}
+			char * q = buf;
+			for(const char * c = digits_begin; c < digits_end; ++c){
+				if(*c != '.') *(q++) = *c;
+			}
+			long long e = written_exponent - static_cast<long long>(num_fraction);
+			*(q++) = 'e';
+			if(e < 0){
+				*(q++) = '-';
+				e = -e;
+			}
+			char * e_begin = q;
+			do{
+				*(q++) = static_cast<char>('0' + e % 10);
+				e /= 10;
+			}while(e > 0);
+			std::reverse(e_begin, q);
+			*q = '\0';
+			char * parsed_end;
+			v = parsing::parse(buf, &parsed_end);
+			if(v == std::numeric_limits<FLOATTYPE>::infinity()) return false;
 		}
+		*pf = negative ? -v : v;
+		return true;
 	}
 
+	// The built-in converters also keep the signature of older versions, "conv(void * target, const std::string & s)",
+	// for the converters written on top of them
 	template<class T>
 	struct Converter{
-		bool operator()(void *, const std::string &) const{
+		bool operator()(T &, const char *, size_t) const{
 			// do nothing
 			return false;
 		}
+		bool operator()(void *, const std::string &) const{
+			return false;
+		}
 	};
 
 	template<>
 	struct Converter<char>{
-		bool operator()(void * target, const std::string & s) const{
-			if(s.length() != 1) return false;
-			*(static_cast<char *>(target)) = s[0];
+		bool operator()(char & target, const char * s, size_t len) const{
+			if(len != 1) return false;
+			target = s[0];
 			return true;
 		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<char *>(target), s.data(), s.length());
+		}
 	};
 
 	template<>
 	struct Converter<std::string>{
-		bool operator()(void * target, const std::string & s) const{
-			(static_cast<std::string *>(target))->assign(s);
+		bool operator()(std::string & target, const char * s, size_t len) const{
+			target.assign(s, len);
 			return true;
 		}
-	};
-
-	template<>
-	struct Converter<long long int>{
 		bool operator()(void * target, const std::string & s) const{
-			return signed_int_converter(static_cast<long long int *>(target), s, std::strtoll);
+			return (*this)(*static_cast<std::string *>(target), s.data(), s.length());
 		}
 	};
 
+	// The value refers to the command line (argv) itself, without copying.
+	// When called with "const std::string & s", it refers to "s".
 	template<>
-	struct Converter<unsigned long long int>{
-		bool operator()(void * target, const std::string & s) const{
-			// Fail if the string begins with a minus sign
-			return unsigned_int_converter(static_cast<unsigned long long int *>(target), s, std::strtoull);
+	struct Converter<string_view>{
+		bool operator()(string_view & target, const char * s, size_t len) const{
+			target = string_view(s, len);
+			return true;
 		}
-	};
-
-	template<>
-	struct Converter<long int>{
 		bool operator()(void * target, const std::string & s) const{
-			return signed_int_converter(static_cast<long int *>(target), s, std::strtol);
+			return (*this)(*static_cast<string_view *>(target), s.data(), s.length());
 		}
 	};
 
+	// The parameter must be null-terminated at s[len], which holds for the parameters given to topion_parse
 	template<>
-	struct Converter<unsigned long int>{
+	struct Converter<const char *>{
+		bool operator()(const char * & target, const char * s, size_t) const{
+			target = s;
+			return true;
+		}
 		bool operator()(void * target, const std::string & s) const{
-			return unsigned_int_converter(static_cast<unsigned long int *>(target), s, std::strtoul);
+			return (*this)(*static_cast<const char **>(target), s.c_str(), s.length());
 		}
 	};
 
-	template<>
-	struct Converter<int>{
-		bool operator()(void * target, const std::string & s) const{
-			long int li;
-			if(!Converter<long int>()(&li, s)) return false;
+	// Contents of a file (or the standard input for "-") kept in memory, followed by a null character.
+	// Regular files are memory-mapped privately, so that they can be split into arguments in place
+	// without copying and without modifying the file.
+	class FileContent{
+	public:
+		FileContent(const FileContent &) = delete;
+		FileContent & operator=(const FileContent &) = delete;
 
-			*(static_cast<int *>(target)) = static_cast<int>(li);
-			return(static_cast<long int>(*(static_cast<int *>(target))) == li);
+		~FileContent(){
+#ifdef TOPION_USE_MMAP
+			if(mapped) ::munmap(data, mapped);
+#endif
+			if(!mapped) std::free(data);
 		}
-	};
 
-	template<>
-	struct Converter<unsigned int>{
-		bool operator()(void * target, const std::string & s) const{
-			unsigned long int uli;
-			if(!Converter<unsigned long int>()(&uli, s)) return false;
-
-			*(static_cast<unsigned int *>(target)) = static_cast<unsigned int>(uli);
-			return(static_cast<unsigned long int>(*(static_cast<unsigned int *>(target))) == uli);
+		// Returns nullptr if the file cannot be read
+		static std::shared_ptr<FileContent> open(const char * path){
+			std::shared_ptr<FileContent> f(new FileContent());
+			bool is_stdin = (std::strcmp(path, "-") == 0);
+#ifdef TOPION_USE_MMAP
+			int fd = is_stdin ? 0 : ::open(path, O_RDONLY);
+			if(fd < 0) return nullptr;
+			struct stat st;
+			bool ok = (::fstat(fd, &st) == 0);
+			if(ok && S_ISREG(st.st_mode)){
+				ok = f->map(fd, static_cast<size_t>(st.st_size));
+			}else if(ok){
+				ok = f->read_all(fd);
+			}
+			if(!is_stdin) ::close(fd);
+			if(!ok) return nullptr;
+#else
+			std::FILE * fp = is_stdin ? stdin : std::fopen(path, "rb");
+			if(fp == nullptr) return nullptr;
+			bool ok = f->read_all(fp);
+			if(!is_stdin) std::fclose(fp);
+			if(!ok) return nullptr;
+#endif
+			return f;
 		}
-	};
 
-	template<>
-	struct Converter<short>{
-		bool operator()(void * target, const std::string & s) const{
-			long int li;
-			if(!Converter<long int>()(&li, s)) return false;
+		// Copies a buffer (nullptr if the memory cannot be allocated)
+		static std::shared_ptr<FileContent> copy(const char * buf, size_t len){
+			std::shared_ptr<FileContent> f(new FileContent());
+			size_t capacity = 0;
+			if(!f->append(buf, len, capacity)) return nullptr;
+			return f;
+		}
 
-			*(static_cast<short *>(target)) = static_cast<short>(li);
-			return(static_cast<long int>(*(static_cast<short *>(target))) == li);
+		// A buffer of "len" bytes to be filled by the caller (nullptr if the memory cannot be allocated)
+		static std::shared_ptr<FileContent> allocate(size_t len){
+			std::shared_ptr<FileContent> f(new FileContent());
+			f->data = static_cast<char *>(std::malloc(len + 1));
+			if(f->data == nullptr) return nullptr;
+			f->size = len;
+			f->data[len] = '\0';
+			return f;
 		}
-	};
 
-	template<>
-	struct Converter<unsigned short>{
-		bool operator()(void * target, const std::string & s) const{
-			unsigned long int uli;
-			if(!Converter<unsigned long int>()(&uli, s)) return false;
+		char * begin(){ return data; }
+		char * end(){ return data + size; }
 
-			*(static_cast<unsigned short *>(target)) = static_cast<unsigned short>(uli);
-			return(static_cast<unsigned long int>(*(static_cast<unsigned short *>(target))) == uli);
-		}
-	};
+	private:
+		char * data = nullptr;
+		size_t size = 0;
+		size_t mapped = 0; // length of the mapping (0 if "data" is allocated by malloc)
 
-	template<>
-	struct Converter<double>{
-		bool operator()(void * target, const std::string & s) const{
-			char * ptr;
-			*(static_cast<double *>(target)) = std::strtod(s.c_str(), &ptr);
-			return ptr == s.c_str() + s.length();
-		}
-	};
+		FileContent(){}
 
-	template<>
-	struct Converter<float>{
-		bool operator()(void * target, const std::string & s) const{
-			double d;
-			if(!Converter<double>()(&d, s)) return false;
+		bool append(const char * buf, size_t len, size_t & capacity){
+			if(size + len + 1 > capacity){
+				size_t newcap = std::max(capacity * 2, size + len + 1);
+				char * p = static_cast<char *>(std::realloc(data, newcap));
+				if(p == nullptr) return false;
+				data = p;
+				capacity = newcap;
+			}
+			std::memcpy(data + size, buf, len);
+			size += len;
+			data[size] = '\0';
+			return true;
+		}
 
-			if(d <= std::numeric_limits<float>::lowest() || d >= std::numeric_limits<float>::max()){
+#ifdef TOPION_USE_MMAP
+		bool map(int fd, size_t len){
+			if(len == 0) return read_all(fd);
+			// Reserve one more page, so that the null character after the end is always addressable
+			size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+			size_t total = (len / page + 1) * page;
+			void * area = ::mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if(area == MAP_FAILED) return false;
+			if(::mmap(area, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED){
+				::munmap(area, total);
 				return false;
 			}
-			*(static_cast<float *>(target)) = static_cast<float>(d);
+			data = static_cast<char *>(area);
+			size = len;
+			mapped = total;
 			return true;
 		}
-	};
-
-	struct Case{
-		std::string name_long;
-		char name_short;
-		void * target;
-		std::string type_name;
-		converter_type conv;
-		std::string description;
-		std::string default_value;
 
-		Case(const std::string & sw_long, char sw_short){
-			if(sw_long.length() == 0){
-				throw topion_definition_error("Empty switch is not allowed.");
-			}else if(sw_long.length() == 1){
-				if(sw_short != '\0'){
-					throw topion_definition_error("Multiple short switch is not allowed. (In case the variable name is one-character, do NOT specify the short switch.)");
-				}
-				name_long = "";
-				name_short = sw_long[0];
-			}else{
-				name_long = sw_long;
-				for(size_t i = 0; i < name_long.length(); ++i){
-					if(name_long[i] == '_') name_long[i] = '-';
+		bool read_all(int fd){
+			size_t capacity = 0;
+			char buf[65536];
+			if(!append("", 0, capacity)) return false;
+			for(;;){
+				ssize_t r = ::read(fd, buf, sizeof(buf));
+				if(r == 0) return true;
+				if(r < 0){
+					if(errno == EINTR) continue;
+					return false;
 				}
-				name_short = sw_short;
+				if(!append(buf, static_cast<size_t>(r), capacity)) return false;
+			}
+		}
+#else
+		bool read_all(std::FILE * fp){
+			size_t capacity = 0;
+			char buf[65536];
+			if(!append("", 0, capacity)) return false;
+			for(;;){
+				size_t r = std::fread(buf, 1, sizeof(buf), fp);
+				if(r > 0 && !append(buf, r, capacity)) return false;
+				if(r < sizeof(buf)) return !std::ferror(fp);
 			}
 		}
+#endif
 	};
 
-	using caselist_type = std::deque<Case>;
-	using name2case_type = std::unordered_map<std::string, size_t>;
-	using specification_type = std::unordered_map<size_t, const char *>;
-	using mandatory_list_type = std::deque<size_t>;
+	// Splits a file content into arguments in place: by null characters if it contains any (like "find -print0"),
+	// by newlines otherwise (empty lines are skipped, and "\r" before "\n" is removed).
+	class FileArguments{
+	public:
+		FileArguments() : cur(nullptr), last(nullptr), separator('\0') {}
+		FileArguments(FileContent & f) : cur(f.begin()), last(f.end()){
+			separator = (std::memchr(cur, '\0', last - cur) != nullptr) ? '\0' : '\n';
+		}
 
-	inline void register_name2case(caselist_type & top, name2case_type & tnc, const std::string & name_long, char name_short, size_t position){
-		if(!(name_long.empty())){
-			if(tnc.count(name_long) > 0){
-				std::stringstream ss;
-				ss << "Switch \"--" << name_long << "\" is specified twice.";
-				throw topion_definition_error(ss.str());
+		bool next(const char * & arg){
+			while(cur < last){
+				char * sep = static_cast<char *>(std::memchr(cur, separator, last - cur));
+				if(sep == nullptr){
+					sep = last; // The content is followed by a null character
+				}else{
+					*sep = '\0';
+				}
+				char * begin = cur;
+				cur = sep + 1;
+				if(separator == '\n' && sep > begin && sep[-1] == '\r') *(--sep) = '\0';
+				if(sep > begin){
+					arg = begin;
+					return true;
+				}
 			}
-#ifdef TOPION_DEBUG
-std::cerr << "Added long switch \"--" << name_long << "\"" << std::endl;
-#endif
-			tnc[name_long] = top.size() - 1;
+			return false;
 		}
 
-		if(name_short != '\0'){
-			std::string name_short_str(1, name_short);
-			if(tnc.count(name_short_str) > 0){
-				std::stringstream ss;
-				ss << "Switch \"-" << name_short_str << "\" is specified twice.";
-				throw topion_definition_error(ss.str());
+		// Same as above without writing to the content, so that the pages of a mapped file stay clean
+		// (the arguments are not null-terminated)
+		bool next(string_view & arg){
+			while(cur < last){
+				char * sep = static_cast<char *>(std::memchr(cur, separator, last - cur));
+				if(sep == nullptr) sep = last;
+				const char * begin = cur;
+				size_t len = sep - cur;
+				cur = sep + 1;
+				if(separator == '\n' && len > 0 && begin[len - 1] == '\r') --len;
+				if(len > 0){
+					arg = string_view(begin, len);
+					return true;
+				}
 			}
-			tnc[name_short_str] = top.size() - 1;
-#ifdef TOPION_DEBUG
-std::cerr << "Added short switch \"-" << name_short_str << "\"" << std::endl;
-#endif
+			return false;
 		}
-	}
 
-	template <class T>
-	struct CaseAddition{
-		CaseAddition(caselist_type & top, name2case_type & tnc, mandatory_list_type & ml, bool mandatory, const char * tname, T & target, converter_type converter, const std::string & sw_long, char sw_short, const std::string & desc){
-			Case c(sw_long, sw_short);
+	private:
+		char * cur;
+		char * last;
+		char separator;
+	};
 
-			c.target = (void *)(&target);
-			c.type_name = tname;
-			c.conv = converter;
-			c.description = desc;
-			c.default_value = "";
-			top.push_back(c);
+	// The arguments of the command line, where "@FILE" is replaced by the arguments in FILE (if enabled)
+	class ArgumentStream{
+	public:
+		ArgumentStream(int argc, char ** argv, bool expand, buffer_type<std::shared_ptr<FileContent>> & files) :
+			argc(argc), argv(argv), i(0), expand(expand), expand_first(expand), in_file(false),
+			files(files), first_file(files.size()), reused(files.size()), failed(nullptr) {}
 
-			register_name2case(top, tnc, c.name_long, c.name_short, top.size() - 1);
-			if(mandatory){
-				ml.push_back(top.size() - 1);
+		bool next(const char * & arg){
+			if(in_file){
+				if(file.next(arg)) return true;
+				in_file = false;
 			}
-		}
-	};
+			for(;;){
+				++i;
+				if(i >= argc) return false;
+				if(!expand || argv[i][0] != '@') break;
 
-	template <>
+				std::shared_ptr<FileContent> f;
+				if(reused < files.size()){
+					f = files[reused++];
+				}else{
+					f = FileContent::open(&(argv[i][1]));
+					if(!f){
+						failed = argv[i];
+						return false;
+					}
+					files.push_back(f);
+					reused = files.size();
+				}
+				file = FileArguments(*f);
+				if(file.next(arg)){
+					in_file = true;
+					return true;
+				}
+			}
+			arg = argv[i];
+			return true;
+		}
+
+		// Stops replacing "@FILE" (after "--")
+		void stop_expansion(){
+			expand = false;
+		}
+
+		// Reads a file given in the arguments (nullptr if it cannot be read), kept with the files of "@FILE".
+		// After rewind, the file already read is handed over again (and no longer kept) instead.
+		std::shared_ptr<FileContent> open_file(const char * path){
+			if(reused < files.size()){
+				std::shared_ptr<FileContent> f;
+				f.swap(files[reused++]);
+				return f;
+			}
+			std::shared_ptr<FileContent> f = FileContent::open(path);
+			if(f){
+				files.push_back(f);
+				reused = files.size();
+			}
+			return f;
+		}
+
+		// Keeps a block the arguments refer to (e.g., the paths matching a glob pattern) with the files read
+		void keep(const std::shared_ptr<FileContent> & block){
+			files.push_back(block);
+			reused = files.size();
+		}
+
+		// Goes back to the first argument, reusing the files already read
+		void rewind(){
+			i = 0;
+			expand = expand_first;
+			in_file = false;
+			reused = first_file;
+		}
+
+		// The index in argv of the last argument read (or the "@FILE" containing it)
+		size_t position() const{
+			return static_cast<size_t>(i);
+		}
+
+		// The "@FILE" argument that could not be read (nullptr if none)
+		const char * failed_file() const{
+			return failed;
+		}
+
+	private:
+		int argc;
+		char ** argv;
+		int i;
+		bool expand;
+		bool expand_first;
+		bool in_file;
+		FileArguments file;
+		buffer_type<std::shared_ptr<FileContent>> & files;
+		size_t first_file; // index in "files" of the first file read by this stream
+		size_t reused; // index in "files" of the next file to be read again after rewind
+		const char * failed;
+	};
+
+	// Splits a command line into words in place, by the quoting rules of the POSIX shell without any expansion:
+	// the words are separated by spaces, characters in '...' are taken as they are, a backslash in "..." escapes only $ ` " \ and a newline,
+	// and a backslash outside quotes escapes any character. A word beginning with '#' starts a comment.
+	// The words are null-terminated. Returns false if a quotation is not terminated.
+	template <class WordList>
+	bool split_words(char * p, char * end, WordList & words){
+		for(;;){
+			while(p < end && is_space(*p)) ++p;
+			if(p == end || *p == '#') return true;
+			char * word = p;
+			char * out = p; // the unquoted word is written over the quoted one
+			while(p < end && !is_space(*p)){
+				if(*p == '\''){
+					char * close = static_cast<char *>(std::memchr(p + 1, '\'', end - p - 1));
+					if(close == nullptr) return false;
+					std::memmove(out, p + 1, close - p - 1);
+					out += close - p - 1;
+					p = close + 1;
+				}else if(*p == '"'){
+					for(++p; ; ){
+						if(p == end) return false;
+						if(*p == '"') break;
+						if(*p == '\\' && p + 1 < end && std::strchr("$`\"\\\n", p[1]) != nullptr){
+							if(p[1] != '\n') *(out++) = p[1];
+							p += 2;
+						}else{
+							*(out++) = *(p++);
+						}
+					}
+					++p;
+				}else if(*p == '\\' && p + 1 < end){
+					if(p[1] != '\n') *(out++) = p[1];
+					p += 2;
+				}else{
+					*(out++) = *(p++);
+				}
+			}
+			*out = '\0'; // over the space after the word (or the end of the line)
+			words.push_back(word);
+			if(p < end) ++p;
+		}
+	}
+
+	// Command lines to be parsed by topion_parse_manifest, one per line of a file or a buffer.
+	// Empty lines and lines beginning with '#' are skipped. The first word of each line is the program name (as argv[0]).
+	class Manifest{
+	public:
+		// Reads a file ("-" for the standard input), raising topion_parsing_error if it cannot be read
+		explicit Manifest(const char * path) : content(FileContent::open(path)){
+			if(!content){
+				std::stringstream ss;
+				ss << "Cannot read the manifest \"" << path << "\".";
+				throw topion_parsing_error(ss.str());
+			}
+			find_lines();
+		}
+
+		// Copies a buffer
+		Manifest(const char * data, size_t size) : content(FileContent::copy(data, size)){
+			if(!content) throw std::bad_alloc();
+			find_lines();
+		}
+
+		// Number of the command lines
+		size_t size() const{
+			return records.size();
+		}
+
+		// Line number (from 1) of the command line
+		size_t line(size_t record) const{
+			return records[record].line;
+		}
+
+		// Splits the command line into "argv" (followed by nullptr), which refers to the manifest.
+		// Each command line can be split only once, since it is split in place.
+		bool split(size_t record, std::vector<char *> & argv){
+			argv.clear();
+			bool ok = split_words(records[record].begin, records[record].end, argv);
+			argv.push_back(nullptr);
+			return ok;
+		}
+
+	private:
+		struct Record{
+			char * begin;
+			char * end;
+			size_t line;
+		};
+		std::shared_ptr<FileContent> content;
+		std::vector<Record> records;
+
+		void find_lines(){
+			char * p = content->begin();
+			char * last = content->end();
+			for(size_t line = 1; p < last; ++line){
+				char * eol = static_cast<char *>(std::memchr(p, '\n', last - p));
+				if(eol == nullptr) eol = last;
+				char * first = p;
+				while(first < eol && is_space(*first)) ++first;
+				if(first < eol && *first != '#'){
+					Record r = {p, eol, line};
+					records.push_back(r);
+				}
+				p = eol + 1;
+			}
+		}
+	};
+
+	// An error in a command line of a manifest
+	struct BatchError{
+		size_t line;
+		std::string message;
+	};
+
+	// Hands out the ranges of [0, n) to threads through an atomic counter, so that a thread finishing early takes more
+	class WorkQueue{
+	public:
+		WorkQueue(size_t n, size_t chunk) : n(n), chunk(chunk), cursor(0) {}
+
+		bool next(size_t & first, size_t & last){
+			first = cursor.fetch_add(chunk, std::memory_order_relaxed);
+			if(first >= n) return false;
+			last = std::min(n, first + chunk);
+			return true;
+		}
+
+	private:
+		size_t n;
+		size_t chunk;
+		std::atomic<size_t> cursor;
+	};
+
+	// Number of the threads to run "tasks" tasks (0 for as many as the hardware threads)
+	inline unsigned worker_count(unsigned threads, size_t tasks){
+		if(threads == 0) threads = std::thread::hardware_concurrency();
+		if(threads > tasks) threads = static_cast<unsigned>(tasks);
+		return threads == 0 ? 1 : threads;
+	}
+
+	// Runs "worker(id)" for each id in [0, threads) at the same time (the id 0 on the calling thread),
+	// and rethrows the first exception thrown by them after all of them finish
+	template <class WORKER>
+	void run_workers(unsigned threads, WORKER worker){
+		std::vector<std::exception_ptr> thrown(threads);
+		std::vector<std::thread> pool;
+		try{
+			for(unsigned id = 1; id < threads; ++id){
+				pool.emplace_back([&worker, &thrown, id](){
+					try{
+						worker(id);
+					}catch(...){
+						thrown[id] = std::current_exception();
+					}
+				});
+			}
+			worker(0);
+		}catch(...){
+			thrown[0] = std::current_exception();
+		}
+		for(auto it = pool.begin(); it != pool.end(); ++it) it->join();
+		for(auto it = thrown.begin(); it != thrown.end(); ++it){
+			if(*it) std::rethrow_exception(*it);
+		}
+	}
+
+	// Type of a switch whose parameter is a file (or "-" for the standard input) listing standalone parameters
+	struct StandaloneFile{
+		string_view path;
+	};
+
+	template<>
+	struct Converter<StandaloneFile>{
+		bool operator()(StandaloneFile & target, const char * s, size_t len) const{
+			target.path = string_view(s, len);
+			return true;
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<StandaloneFile *>(target), s.data(), s.length());
+		}
+	};
+
+	// ------------------------------------------------------------
+	// Glob patterns in the standalone parameters (TOPION_EXPAND_GLOBS)
+	// ------------------------------------------------------------
+	// Whether [p, end) has a wildcard ("*", "?" or "[") not escaped by a backslash
+	inline bool has_wildcard(const char * p, const char * end){
+		for(; p < end; ++p){
+			if(*p == '\\' && p + 1 < end){
+				++p;
+			}else if(*p == '*' || *p == '?' || *p == '['){
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Matches "c" with the bracket expression after "[" at "p" (e.g., "a-z]" or "!0-9]"), moving "p" after "]".
+	// Returns false if it is not a bracket expression (no "]" follows), where "[" is an ordinary character.
+	inline bool match_bracket(const char * & p, const char * end, char c, bool & matched){
+		const char * q = p;
+		bool negate = (q < end && (*q == '!' || *q == '^'));
+		if(negate) ++q;
+		unsigned char u = static_cast<unsigned char>(c);
+		matched = false;
+		for(bool first = true; q < end && (first || *q != ']'); first = false){
+			if(*q == '\\' && q + 1 < end) ++q;
+			unsigned char lo = static_cast<unsigned char>(*q++), hi = lo;
+			if(q + 1 < end && *q == '-' && q[1] != ']'){
+				++q;
+				if(*q == '\\' && q + 1 < end) ++q;
+				hi = static_cast<unsigned char>(*q++);
+			}
+			if(lo <= u && u <= hi) matched = true;
+		}
+		if(q >= end) return false;
+		p = q + 1;
+		if(negate) matched = !matched;
+		return true;
+	}
+
+	// Whether the name [n, nend) matches the pattern [p, pend) of one component of a path
+	inline bool glob_match(const char * p, const char * pend, const char * n, const char * nend){
+		const char * star_p = nullptr; // the pattern after the last "*"
+		const char * star_n = nullptr; // the end of the characters taken by the last "*"
+		while(n < nend){
+			if(p < pend){
+				if(*p == '*'){
+					star_p = ++p;
+					star_n = n;
+					continue;
+				}
+				const char * q = p + 1;
+				bool matched = true;
+				if(*p != '?' && (*p != '[' || !match_bracket(q, pend, *n, matched))){
+					char c = *p;
+					if(c == '\\' && q < pend) c = *q++;
+					matched = (c == *n);
+				}
+				if(matched){
+					p = q;
+					++n;
+					continue;
+				}
+			}
+			// Let the last "*" take one more character
+			if(star_p == nullptr) return false;
+			p = star_p;
+			n = ++star_n;
+		}
+		while(p < pend && *p == '*') ++p;
+		return p == pend;
+	}
+
+	// Expands a glob pattern into the paths matching it, as the shell does: "*", "?" and "[...]" match the names
+	// in each directory of the path (not "/", nor a "." at the beginning of a name), and "\" escapes a character.
+	// The directories are read by "threads" threads (0 for as many as the hardware threads) a few directories ahead,
+	// and "deliver(const std::shared_ptr<FileContent> & paths)" is called by the calling thread for each directory
+	// with the paths matching in it (null-separated, in the order of the names), until it returns false.
+	// Returns false if no path matches (or the directories cannot be read on this platform).
+	class GlobExpansion{
+	public:
+		explicit GlobExpansion(const char * pattern){
+			const char * p = pattern;
+			if(*p == '/'){
+				root = "/";
+				while(*p == '/') ++p;
+			}
+			for(;;){
+				const char * slash = std::strchr(p, '/');
+				const char * end = slash ? slash : p + std::strlen(p);
+				Component c = {p, end, has_wildcard(p, end)};
+				components.push_back(c);
+				if(slash == nullptr) break;
+				p = slash + 1;
+			}
+		}
+
+		template <class DELIVER>
+		bool run(unsigned threads, DELIVER deliver){
+#ifdef TOPION_USE_DIRENT
+			std::list<Directory> order; // the directories to be read, in the order of the paths
+			std::mutex mutex;
+			std::condition_variable changed;
+			bool done = false;
+			bool matched = false;
+			Directory first = {root, 0, Directory::waiting, {}, nullptr, nullptr};
+			order.push_back(first);
+			unsigned workers = worker_count(threads, std::numeric_limits<size_t>::max());
+			const size_t window = 4 * workers; // the directories read ahead
+
+			run_workers(workers, [&](unsigned id){
+				std::unique_lock<std::mutex> lock(mutex);
+				if(id != 0){
+					// Read the first directories not read yet
+					for(;;){
+						if(done) return;
+						auto it = order.begin();
+						for(size_t i = 0; it != order.end() && i < window && it->state != Directory::waiting; ++i) ++it;
+						if(it != order.end() && it->state == Directory::waiting){
+							read_locked(*it, lock);
+							changed.notify_all();
+						}else{
+							changed.wait(lock);
+						}
+					}
+				}
+
+				// The calling thread passes the paths in order, reading the directory by itself if no thread has started it
+				try{
+					while(!order.empty()){
+						Directory & d = order.front();
+						if(d.state == Directory::waiting){
+							read_locked(d, lock);
+							changed.notify_all();
+						}else{
+							changed.wait(lock, [&d]{ return d.state == Directory::read; });
+						}
+						if(d.thrown) std::rethrow_exception(d.thrown);
+						Directory current = std::move(d);
+						order.pop_front();
+						changed.notify_all(); // the window moves on
+						if(current.paths){
+							matched = true;
+							lock.unlock();
+							bool more = deliver(current.paths);
+							lock.lock();
+							if(!more) break;
+						}else{
+							// Descend into the subdirectories in the order of the names
+							for(auto it = current.names.rbegin(); it != current.names.rend(); ++it){
+								Directory sub = {current.path + *it + '/', current.component + 1, Directory::waiting, {}, nullptr, nullptr};
+								order.push_front(std::move(sub));
+							}
+							changed.notify_all();
+						}
+					}
+				}catch(...){
+					if(!lock.owns_lock()) lock.lock();
+					done = true;
+					changed.notify_all();
+					throw;
+				}
+				done = true;
+				changed.notify_all();
+			});
+			return matched;
+#else
+			(void)threads;
+			(void)deliver;
+			return false;
+#endif // TOPION_USE_DIRENT
+		}
+
+	private:
+		struct Component{
+			const char * begin;
+			const char * end;
+			bool wildcard;
+		};
+
+		struct Directory{
+			enum State{ waiting, reading, read };
+			std::string path; // ending with "/" (or empty for the current directory)
+			size_t component; // the component of the pattern matched in the directory
+			State state;
+			std::vector<std::string> names; // the names matching, if the component is not the last
+			std::shared_ptr<FileContent> paths; // the paths matching, if the component is the last
+			std::exception_ptr thrown;
+		};
+
+#ifdef TOPION_USE_DIRENT
+		// Reads a directory, releasing the lock meanwhile
+		void read_locked(Directory & d, std::unique_lock<std::mutex> & lock) const{
+			d.state = Directory::reading;
+			lock.unlock();
+			try{
+				read(d);
+			}catch(...){
+				d.thrown = std::current_exception();
+			}
+			lock.lock();
+			d.state = Directory::read;
+		}
+
+		// The names matching in the directory are held at once to be sorted, so a directory of a million matches
+		// takes its names and then the block of its paths in memory (the paths of the other directories are not held)
+		void read(Directory & d) const{
+			const Component & c = components[d.component];
+			bool last = (d.component + 1 == components.size());
+			std::string found; // the names matching, each followed by a null character
+			std::vector<size_t> starts; // the positions of the names in "found"
+			if(!c.wildcard){
+				for(const char * p = c.begin; p < c.end; ++p){
+					if(*p == '\\' && p + 1 < c.end) ++p;
+					found += *p;
+				}
+				struct stat st;
+				if(!last || ::lstat((d.path + found).c_str(), &st) == 0) starts.push_back(0);
+				found += '\0';
+			}else if(DIR * dir = ::opendir(d.path.empty() ? "." : d.path.c_str())){
+				while(struct dirent * e = ::readdir(dir)){
+					const char * n = e->d_name;
+					if(n[0] == '.' && *c.begin != '.') continue;
+					if(n[0] == '.' && (n[1] == '\0' || (n[1] == '.' && n[2] == '\0'))) continue;
+#ifdef DT_DIR
+					if(!last && e->d_type != DT_DIR && e->d_type != DT_LNK && e->d_type != DT_UNKNOWN) continue;
+#endif
+					size_t len = std::strlen(n);
+					if(glob_match(c.begin, c.end, n, n + len)){
+						starts.push_back(found.size());
+						found.append(n, len + 1);
+					}
+				}
+				::closedir(dir);
+				const char * names = found.data();
+				std::sort(starts.begin(), starts.end(), [names](size_t a, size_t b){ return std::strcmp(names + a, names + b) < 0; });
+			}
+			if(!last){
+				for(auto it = starts.begin(); it != starts.end(); ++it) d.names.emplace_back(found.data() + *it);
+			}else if(!starts.empty()){
+				// The paths are written once, straight into the block passed on
+				d.paths = FileContent::allocate(starts.size() * d.path.size() + found.size());
+				if(!d.paths) throw std::bad_alloc();
+				char * out = d.paths->begin();
+				for(auto it = starts.begin(); it != starts.end(); ++it){
+					std::memcpy(out, d.path.data(), d.path.size());
+					out += d.path.size();
+					size_t len = std::strlen(found.data() + *it) + 1;
+					std::memcpy(out, found.data() + *it, len);
+					out += len;
+				}
+			}
+		}
+#endif // TOPION_USE_DIRENT
+
+		std::string root;
+		std::vector<Component> components;
+	};
+
+	// Standalone parameters counted before they are passed to a sink
+	struct StandaloneCount{
+		size_t num = 0;
+		bool partial = false; // the entries of the files of standalone parameters (or the paths matching the patterns) are not counted yet
+	};
+
+	// The beginning of a snapshot made by topion_snapshot, followed by the SnapshotEntry of the switches,
+	// the SnapshotEntry of the standalone parameters and the data they refer to
+	struct SnapshotHeader{
+		char magic[8]; // "TOPION\0" followed by snapshot_version
+		std::uint64_t layout; // Schema::layout of the struct
+		std::uint64_t size; // of the whole snapshot
+		std::uint64_t values; // number of the SnapshotEntry of the switches
+		std::uint64_t standalones; // number of the SnapshotEntry of the standalone parameters
+	};
+
+	struct SnapshotEntry{
+		std::uint64_t case_id; // the switch (not used for standalone parameters)
+		std::uint64_t offset; // from the beginning of the snapshot
+		std::uint64_t length; // bytes of the value (PlainValue), or of the string followed by a null character
+	};
+
+	// A parameter given to a switch
+	struct Specification{
+		size_t case_id;
+		const char * value;
+		size_t position; // the index in argv of the switch (or the "@FILE" containing it)
+	};
+
+	// The result of converting a parameter on a thread, gathered after all the conversions finish
+	struct ConversionOutcome{
+		bool converted = false;
+		std::exception_ptr thrown;
+#ifdef TOPION_STATS
+		bool run = false;
+		double ns = 0;
+#endif // TOPION_STATS
+	};
+
+	// Calls a converter with the parameter, statically dispatched by the signature of the converter
+	template<class T, class CONV>
+	struct Conversion{
+		template<class C>
+		static auto call(const C & conv, T & target, const char * s, size_t len, int) -> decltype(static_cast<bool>(conv(target, s, len))){
+			return conv(target, s, len);
+		}
+
+		// A converter of the older signature (converter_type)
+		template<class C>
+		static bool call(const C & conv, T & target, const char * s, size_t len, long){
+			static thread_local std::string buffer;
+			buffer.assign(s, len);
+			return conv(static_cast<void *>(&target), static_cast<const std::string &>(buffer));
+		}
+
+		static bool convert(const void * conv, void * target, const char * s, size_t len){
+			return call(*static_cast<const CONV *>(conv), *static_cast<T *>(target), s, len, 0);
+		}
+	};
+
+	// A converter may have "void prepare()", called once on its copy kept for the switch when the switch is registered
+	// (e.g., to build a table), and "std::string allowed() const", the values accepted, shown after the description in the usage
+	struct ConverterHooks{
+		template<class C>
+		static auto prepare(C & conv, int) -> decltype(conv.prepare(), void()){
+			conv.prepare();
+		}
+
+		template<class C>
+		static void prepare(C &, long){}
+
+		template<class C>
+		static auto allowed(const C & conv, int) -> decltype(std::string(conv.allowed())){
+			return conv.allowed();
+		}
+
+		template<class C>
+		static std::string allowed(const C &, long){
+			return std::string();
+		}
+
+		// Tells the converter the switch it converts (e.g., "--name"), once its case is added
+		template<class C>
+		static auto bind(C & conv, const std::string & label, int) -> decltype(conv.bind(label), void()){
+			conv.bind(label);
+		}
+
+		template<class C>
+		static void bind(C &, const std::string &, long){}
+	};
+
+	template<>
+	struct Converter<long long int>{
+		bool operator()(long long int & target, const char * s, size_t len) const{
+			return integer_converter(&target, s, len);
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<long long int *>(target), s.data(), s.length());
+		}
+	};
+
+	template<>
+	struct Converter<unsigned long long int>{
+		bool operator()(unsigned long long int & target, const char * s, size_t len) const{
+			return integer_converter(&target, s, len);
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<unsigned long long int *>(target), s.data(), s.length());
+		}
+	};
+
+	template<>
+	struct Converter<long int>{
+		bool operator()(long int & target, const char * s, size_t len) const{
+			return integer_converter(&target, s, len);
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<long int *>(target), s.data(), s.length());
+		}
+	};
+
+	template<>
+	struct Converter<unsigned long int>{
+		bool operator()(unsigned long int & target, const char * s, size_t len) const{
+			return integer_converter(&target, s, len);
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<unsigned long int *>(target), s.data(), s.length());
+		}
+	};
+
+	template<>
+	struct Converter<int>{
+		bool operator()(int & target, const char * s, size_t len) const{
+			return integer_converter(&target, s, len);
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<int *>(target), s.data(), s.length());
+		}
+	};
+
+	template<>
+	struct Converter<unsigned int>{
+		bool operator()(unsigned int & target, const char * s, size_t len) const{
+			return integer_converter(&target, s, len);
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<unsigned int *>(target), s.data(), s.length());
+		}
+	};
+
+	template<>
+	struct Converter<short>{
+		bool operator()(short & target, const char * s, size_t len) const{
+			return integer_converter(&target, s, len);
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<short *>(target), s.data(), s.length());
+		}
+	};
+
+	template<>
+	struct Converter<unsigned short>{
+		bool operator()(unsigned short & target, const char * s, size_t len) const{
+			return integer_converter(&target, s, len);
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<unsigned short *>(target), s.data(), s.length());
+		}
+	};
+
+	template<>
+	struct Converter<double>{
+		bool operator()(double & target, const char * s, size_t len) const{
+			return floating_converter(&target, s, len);
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<double *>(target), s.data(), s.length());
+		}
+	};
+
+	template<>
+	struct Converter<float>{
+		bool operator()(float & target, const char * s, size_t len) const{
+			return floating_converter(&target, s, len);
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<float *>(target), s.data(), s.length());
+		}
+	};
+
+	// Elements separated by commas ("1,2,3"; empty for no element), added to the vector
+	template<class T, class A>
+	struct Converter<std::vector<T, A>>{
+		static_assert(!std::is_same<T, const char *>::value, "The elements are not null-terminated: use TopionUtil::string_view instead of const char *");
+
+		bool operator()(std::vector<T, A> & target, const char * s, size_t len) const{
+			if(len == 0) return true;
+			const char * end = s + len;
+			target.reserve(target.size() + std::count(s, end, ',') + 1);
+
+			// Each element is converted in place
+			Converter<T> conv;
+			for(;;){
+				const char * sep = s;
+				while(sep < end && *sep != ',') ++sep;
+				target.emplace_back();
+				if(!conv(target.back(), s, sep - s)) return false;
+				if(sep == end) return true;
+				s = sep + 1;
+			}
+		}
+		bool operator()(void * target, const std::string & s) const{
+			return (*this)(*static_cast<std::vector<T, A> *>(target), s.data(), s.length());
+		}
+	};
+
+	// A variable whose parameter is kept by topion_parse and converted when the value is read first
+	// (only once, even if read by several threads at the same time), for converters that cost much
+	template <class T>
+	class Lazy{
+	public:
+		Lazy() : value(), state(ready), parameter_data(nullptr), parameter_length(0), convert(nullptr), converter(nullptr), label(nullptr) {}
+		Lazy(const T & v) : value(v), state(ready), parameter_data(nullptr), parameter_length(0), convert(nullptr), converter(nullptr), label(nullptr) {}
+		Lazy(const Lazy & other) : Lazy(){
+			*this = other;
+		}
+
+		Lazy & operator=(const Lazy & other){
+			if(this == &other) return *this;
+			std::lock(mutex, other.mutex);
+			std::lock_guard<std::mutex> lock(mutex, std::adopt_lock);
+			std::lock_guard<std::mutex> other_lock(other.mutex, std::adopt_lock);
+			value = other.value;
+			state.store(other.state.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			parameter_data = other.parameter_data;
+			parameter_length = other.parameter_length;
+			convert = other.convert;
+			converter = other.converter;
+			label = other.label;
+			return *this;
+		}
+
+		// The value, converted from the parameter at the first call (topion_parsing_error if the parameter is invalid)
+		const T & get() const{
+			if(!resolve()){
+				std::stringstream ss;
+				ss << "An error found when parsing the command line: ";
+				if(label != nullptr) ss << "Switch \"" << label << "\": ";
+				ss << "Value \"" << parameter() << "\" is invalid for this switch." << std::endl;
+				throw topion_parsing_error(ss.str());
+			}
+			return value;
+		}
+
+		const T & operator*() const{
+			return get();
+		}
+
+		const T * operator->() const{
+			return &get();
+		}
+
+		// Converts the parameter if not yet, and returns false if it is invalid
+		bool resolve() const{
+			int s = state.load(std::memory_order_acquire);
+			if(s == pending){
+				std::lock_guard<std::mutex> lock(mutex);
+				s = state.load(std::memory_order_relaxed);
+				if(s == pending){
+					s = convert(converter, &value, parameter_data, parameter_length) ? ready : invalid;
+					state.store(s, std::memory_order_release);
+				}
+			}
+			return s == ready;
+		}
+
+		// The parameter is given but not converted yet
+		bool pending_conversion() const{
+			return state.load(std::memory_order_acquire) == pending;
+		}
+
+		// The parameter given to the switch (empty if none)
+		string_view parameter() const{
+			return parameter_data ? string_view(parameter_data, parameter_length) : string_view();
+		}
+
+		// Keeps the parameter to be converted by "conv" later (by LazyConverter)
+		void defer(const char * s, size_t len, bool (*conv)(const void *, void *, const char *, size_t), const void * conv_object, const char * sw = nullptr){
+			std::lock_guard<std::mutex> lock(mutex);
+			parameter_data = s;
+			parameter_length = len;
+			convert = conv;
+			converter = conv_object;
+			label = sw;
+			state.store(pending, std::memory_order_release);
+		}
+
+	private:
+		enum{ ready, pending, invalid };
+		mutable T value;
+		mutable std::atomic<int> state;
+		mutable std::mutex mutex;
+		const char * parameter_data; // refers to the string given to topion_parse (e.g., argv)
+		size_t parameter_length;
+		bool (*convert)(const void *, void *, const char *, size_t);
+		const void * converter; // kept by the definitions of the switches
+		const char * label; // the switch, named in the error of get (kept by the definitions of the switches)
+	};
+
+	// Defers the conversion by CONV (e.g., "TopionUtil::LazyConverter<Pattern, PatternConverter>(...)" for a variable of Lazy<Pattern>)
+	template <class T, class CONV = Converter<T>>
+	struct LazyConverter{
+		CONV conv;
+		std::string label; // the switch (ConverterHooks::bind)
+
+		LazyConverter(const CONV & c = CONV()) : conv(c) {}
+
+		void bind(const std::string & sw){
+			label = sw;
+		}
+
+		bool operator()(Lazy<T> & target, const char * s, size_t len) const{
+			target.defer(s, len, &Conversion<T, CONV>::convert, &conv, label.empty() ? nullptr : label.c_str());
+			return true;
+		}
+	};
+
+	template <class T>
+	struct Converter<Lazy<T>> : public LazyConverter<T> {};
+
+	// Converts the parameter of a Lazy variable now (Case::resolve)
+	template <class T>
+	struct Laziness{
+		static constexpr bool (*function())(const void *){
+			return nullptr;
+		}
+	};
+
+	template <class T>
+	struct Laziness<Lazy<T>>{
+		static bool resolve(const void * target){
+			return static_cast<const Lazy<T> *>(target)->resolve();
+		}
+		static constexpr bool (*function())(const void *){
+			return &resolve;
+		}
+	};
+
+	struct Case{
+		std::string name_long;
+		char name_short;
+		std::ptrdiff_t offset; // position of the variable, counted from the Topion base of the struct
+		std::string type_name;
+		bool (*convert)(const void *, void *, const char *, size_t); // Conversion<T, CONV>::convert (nullptr for bool)
+		std::shared_ptr<const void> converter; // the copy of the converter object
+		bool standalone_source; // the parameter is a file listing standalone parameters
+		void (*assign)(void *, const void *); // copies the value of the variable (nullptr if not copy-assignable)
+		void (*clear)(void *); // clears the value before the parameters of the switch given repeatedly are added (nullptr if it cannot be repeated)
+		size_t plain_size; // sizeof the variable if it is copied into snapshots as it is (PlainValue), 0 otherwise
+		bool (*resolve)(const void *); // converts the parameter kept by a Lazy variable (nullptr if not Lazy)
+		bool independent; // the converter can run at the same time as the others (TOPION_INDEPENDENT)
+		std::string description;
+		std::string default_value;
+		bool mandatory;
+
+		Case(const std::string & sw_long, char sw_short){
+			if(sw_long.length() == 0){
+				throw topion_definition_error("Empty switch is not allowed.");
+			}else if(sw_long.length() == 1){
+				if(sw_short != '\0'){
+					throw topion_definition_error("Multiple short switch is not allowed. (In case the variable name is one-character, do NOT specify the short switch.)");
+				}
+				name_long = "";
+				name_short = sw_long[0];
+			}else{
+				name_long = sw_long;
+				for(size_t i = 0; i < name_long.length(); ++i){
+					if(name_long[i] == '_') name_long[i] = '-';
+				}
+				name_short = sw_short;
+			}
+			offset = 0;
+			convert = nullptr;
+			standalone_source = false;
+			assign = nullptr;
+			clear = nullptr;
+			plain_size = 0;
+			resolve = nullptr;
+			independent = false;
+			mandatory = false;
+		}
+	};
+
+	template <class T, bool = std::is_copy_assignable<T>::value>
+	struct Assignment{
+		static void assign(void * target, const void * source){
+			*(static_cast<T *>(target)) = *(static_cast<const T *>(source));
+		}
+		static constexpr void (*function())(void *, const void *){
+			return &assign;
+		}
+	};
+
+	template <class T>
+	struct Assignment<T, false>{
+		static constexpr void (*function())(void *, const void *){
+			return nullptr;
+		}
+	};
+
+	// Types whose switches can be given repeatedly, each adding to the value
+	template <class T>
+	struct Repetition{
+		static constexpr void (*function())(void *){
+			return nullptr;
+		}
+	};
+
+	template <class T, class A>
+	struct Repetition<std::vector<T, A>>{
+		static void clear(void * target){
+			static_cast<std::vector<T, A> *>(target)->clear();
+		}
+		static constexpr void (*function())(void *){
+			return &clear;
+		}
+	};
+
+	// Types of the variables whose bytes are copied into snapshots as they are, instead of their parameters
+	// (specialize it as std::true_type for trivially copyable types not referring to any memory)
+	template <class T>
+	struct PlainValue : std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_enum<T>::value> {};
+
+	template <class T>
+	constexpr size_t plain_size(){
+		return PlainValue<T>::value ? sizeof(T) : 0;
+	}
+
+	using caselist_type = std::vector<Case>;
+
+	// One bit for each case, in the order of the cases
+	using caseset_type = buffer_type<std::uint64_t>;
+
+	inline bool caseset_test(const caseset_type & s, size_t p){
+		return (s[p >> 6] >> (p & 63)) & 1;
+	}
+
+	inline void caseset_insert(caseset_type & s, size_t p){
+		s[p >> 6] |= std::uint64_t(1) << (p & 63);
+	}
+
+	inline size_t caseset_words(size_t num_cases){
+		return (num_cases + 63) >> 6;
+	}
+
+	const size_t npos = static_cast<size_t>(-1);
+
+	// Changed when the format of the snapshots changes
+	const std::uint64_t snapshot_version = 1;
+
+	inline std::uint64_t hash_mix(std::uint64_t x){
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ULL;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebULL;
+		x ^= x >> 31;
+		return x;
+	}
+
+	inline std::uint64_t hash_string(const char * s, size_t len, std::uint64_t seed){
+		std::uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+		for(size_t i = 0; i < len; ++i){
+			h ^= static_cast<unsigned char>(s[i]);
+			h *= 0x100000001b3ULL;
+		}
+		return hash_mix(h);
+	}
+
+	// Perfect hash (hash-and-displace) over a fixed set of keys:
+	// "lookup" returns the only index that the string can be equal to, so the caller compares just one key.
+	class PerfectHash{
+	public:
+		using key_type = std::pair<const char *, size_t>;
+
+		// Returns npos on success, or the index of a key equal to an earlier one
+		size_t build(const std::vector<key_type> & keys){
+			size_t n = keys.size();
+			seed = 0;
+			displacement.clear();
+			slots.clear();
+			if(n == 0) return npos;
+
+			// Identical keys can never be separated
+			std::vector<size_t> order(n);
+			for(size_t i = 0; i < n; ++i) order[i] = i;
+			std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b){
+				return std::lexicographical_compare(keys[a].first, keys[a].first + keys[a].second, keys[b].first, keys[b].first + keys[b].second);
+			});
+			for(size_t i = 1; i < n; ++i){
+				const key_type & a = keys[order[i-1]];
+				const key_type & b = keys[order[i]];
+				if(a.second == b.second && std::memcmp(a.first, b.first, a.second) == 0) return order[i];
+			}
+
+			size_t m = 1;
+			while(m < n + n / 2 + 1) m <<= 1;
+			std::vector<std::uint64_t> h(n);
+			for(;;){
+				for(size_t i = 0; i < n; ++i) h[i] = hash_string(keys[i].first, keys[i].second, seed);
+				if(try_build(h, m)) return npos;
+				++seed;
+				if(seed % 4 == 0) m <<= 1;
+			}
+		}
+
+		size_t lookup(const char * s, size_t len) const{
+			if(slots.empty()) return npos;
+			std::uint64_t h = hash_string(s, len, seed);
+			std::uint64_t d = displacement[(h >> 32) % displacement.size()];
+			return slots[hash_mix(h + d * 0x9e3779b97f4a7c15ULL) & (slots.size() - 1)];
+		}
+
+	private:
+		std::uint64_t seed = 0;
+		std::vector<std::uint32_t> displacement;
+		std::vector<size_t> slots;
+
+		bool try_build(const std::vector<std::uint64_t> & h, size_t m){
+			size_t n = h.size();
+			size_t r = (n + 3) / 4;
+			std::vector<std::vector<size_t>> buckets(r);
+			for(size_t i = 0; i < n; ++i) buckets[(h[i] >> 32) % r].push_back(i);
+			std::vector<size_t> border(r);
+			for(size_t b = 0; b < r; ++b) border[b] = b;
+			std::stable_sort(border.begin(), border.end(), [&buckets](size_t a, size_t b){
+				return buckets[a].size() > buckets[b].size();
+			});
+
+			displacement.assign(r, 0);
+			slots.assign(m, npos);
+			std::vector<size_t> trial;
+			for(size_t bi = 0; bi < r; ++bi){
+				const std::vector<size_t> & bucket = buckets[border[bi]];
+				if(bucket.empty()) break;
+				bool placed = false;
+				for(std::uint32_t d = 0; d < 16 * m && !placed; ++d){
+					trial.clear();
+					placed = true;
+					for(size_t k = 0; k < bucket.size(); ++k){
+						size_t s = hash_mix(h[bucket[k]] + d * 0x9e3779b97f4a7c15ULL) & (m - 1);
+						if(slots[s] != npos || std::find(trial.begin(), trial.end(), s) != trial.end()){
+							placed = false;
+							break;
+						}
+						trial.push_back(s);
+					}
+					if(placed){
+						displacement[border[bi]] = d;
+						for(size_t k = 0; k < bucket.size(); ++k) slots[trial[k]] = bucket[k];
+					}
+				}
+				if(!placed) return false;
+			}
+			return true;
+		}
+	};
+
+	// ------------------------------------------------------------
+	// Choices and ranges
+	// ------------------------------------------------------------
+	// A name accepted by a Choice converter, and the value stored for it
+	template <class E>
+	struct ChoiceEntry{
+		const char * name;
+		E value;
+	};
+
+	// A converter accepting the names in a table (typically a static array of ChoiceEntry, e.g., for an enum class)
+	// and storing their values. The names are looked up by a perfect hash built once when the switch is registered.
+	template <class E>
+	class Choice{
+	public:
+		template <size_t N>
+		Choice(const ChoiceEntry<E> (&entries)[N]) : entries(entries), n(N) {}
+		Choice(const ChoiceEntry<E> * entries, size_t n) : entries(entries), n(n) {}
+
+		bool operator()(E & target, const char * s, size_t len) const{
+			size_t i = hash.lookup(s, len);
+			if(i == npos) return false;
+			// "s" may contain a null character, so the lengths are compared first
+			if(lengths[i] != len || std::memcmp(entries[i].name, s, len) != 0) return false;
+			target = entries[i].value;
+			return true;
+		}
+
+		void prepare(){
+			if(n == 0) throw topion_definition_error("Choice must have one name or more.");
+			std::vector<PerfectHash::key_type> keys;
+			keys.reserve(n);
+			lengths.resize(n);
+			for(size_t i = 0; i < n; ++i){
+				lengths[i] = std::strlen(entries[i].name);
+				keys.push_back(PerfectHash::key_type(entries[i].name, lengths[i]));
+			}
+			size_t duplicate = hash.build(keys);
+			if(duplicate != npos){
+				std::stringstream ss;
+				ss << "Choice \"" << entries[duplicate].name << "\" is given twice.";
+				throw topion_definition_error(ss.str());
+			}
+		}
+
+		// e.g., "read, write or scan"
+		std::string allowed() const{
+			std::string s;
+			for(size_t i = 0; i < n; ++i){
+				if(i > 0) s += (i + 1 == n) ? " or " : ", ";
+				s += entries[i].name;
+			}
+			return s;
+		}
+
+	private:
+		const ChoiceEntry<E> * entries;
+		size_t n;
+		std::vector<size_t> lengths; // of the names
+		PerfectHash hash;
+	};
+
+	// A converter accepting the numbers in [lowest, highest], e.g., Range<int>(1, 64).
+	// The bounds of integers are checked while the digits are read (integer_converter), instead of after the conversion.
+	template <class T>
+	class Range{
+		static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "Range is for numbers");
+	public:
+		Range(T lowest, T highest) : lowest(lowest), highest(highest) {}
+
+		bool operator()(T & target, const char * s, size_t len) const{
+			return convert(target, s, len, std::integral_constant<bool, std::is_integral<T>::value && !std::is_same<T, char>::value>());
+		}
+
+		void prepare() const{
+			if(!(lowest <= highest)){
+				std::stringstream ss;
+				ss << "Range of the values invalid: lowest = " << shown(lowest) << ", highest = " << shown(highest);
+				throw topion_definition_error(ss.str());
+			}
+		}
+
+		// e.g., "1 to 64"
+		std::string allowed() const{
+			std::stringstream ss;
+			ss << shown(lowest) << " to " << shown(highest);
+			return ss.str();
+		}
+
+	private:
+		// Numbers of the types of characters (e.g., std::int8_t) are shown as numbers, except char
+		template <class U>
+		static auto shown(U v) -> decltype(+v){
+			return +v;
+		}
+
+		static char shown(char c){
+			return c;
+		}
+
+		bool convert(T & target, const char * s, size_t len, std::true_type) const{
+			return integer_converter(&target, s, len, lowest, highest);
+		}
+
+		bool convert(T & target, const char * s, size_t len, std::false_type) const{
+			T v;
+			if(!Converter<T>()(v, s, len) || !(v >= lowest && v <= highest)) return false;
+			target = v;
+			return true;
+		}
+
+		T lowest;
+		T highest;
+	};
+
+#ifdef TOPION_STATS
+	// Statistics of one topion_parse, kept by each instance (topion_stats) and passed to stats_hook()
+	struct ParseStats{
+		double registration_ns = 0; // building the definitions of the switches of the struct, done once for each struct type
+		double outline_ns = 0; // reading the arguments and looking up the switches
+		double conversion_ns = 0; // converting the parameters, and checking the mandatory switches and the number of the standalone parameters
+		double error_ns = 0; // formatting the message of the exception
+		double total_ns = 0; // the whole topion_parse (including "sink" if given)
+		size_t arguments = 0; // switches and standalone parameters read (the parameters of switches are not counted)
+		size_t lookups = 0; // switches looked up by the names
+		size_t conversions = 0;
+		size_t errors = 0;
+		size_t allocations = 0; // heap allocations, counted only if TOPION_STATS_ALLOCATIONS is defined (see the end of this file)
+		std::string slowest_switch; // the switch whose parameter took the longest to convert
+		double slowest_conversion_ns = 0;
+	};
+
+	using stats_hook_type = void (*)(const ParseStats &);
+
+	// Called at the end of every topion_parse (also when it throws an exception, so the hook must not throw)
+	inline stats_hook_type & stats_hook(){
+		static stats_hook_type hook = nullptr;
+		return hook;
+	}
+
+	inline size_t & allocation_count(){
+		static thread_local size_t count = 0;
+		return count;
+	}
+
+	class StatsClock{
+	public:
+		StatsClock() : last(std::chrono::steady_clock::now()) {}
+
+		// Nanoseconds since the construction or the last lap
+		double lap(){
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			double ns = std::chrono::duration<double, std::nano>(now - last).count();
+			last = now;
+			return ns;
+		}
+
+	private:
+		std::chrono::steady_clock::time_point last;
+	};
+#endif // TOPION_STATS
+
+	// Appends an entry of the usage to "text": "head" followed by "description" indented by "tab_width",
+	// wrapped at "display_width" on the last space in the line (or in the middle of a word longer than the line)
+	inline void append_usage_entry(std::string & text, const std::string & head, const std::string & description, size_t display_width, size_t tab_width){
+		// Option name
+		text += head;
+		if(head.length() < tab_width){
+			text.append(tab_width - head.length(), ' ');
+		}else{
+			text += '\n';
+			text.append(tab_width, ' ');
+		}
+
+		// Description
+		size_t width = display_width - tab_width;
+		size_t n = description.length();
+		size_t p = 0;
+		for(;;){
+			size_t last = description.find('\n', p);
+			if(last == std::string::npos) last = n;
+			if(last - p > width){
+				size_t space = description.rfind(' ', p + width);
+				if(space != std::string::npos && space > p){
+					last = space;
+					while(last > p + 1 && description[last-1] == ' ') --last;
+				}else{
+					last = p + width;
+				}
+			}
+			text.append(description, p, last - p);
+			p = last;
+			if(p == n) break;
+			if(description[p] == '\n'){
+				++p;
+			}else{
+				// The spaces at the wrap are dropped
+				while(p < n && description[p] == ' ') ++p;
+				if(p == n) break;
+				if(description[p] == '\n') ++p;
+			}
+			text += '\n';
+			text.append(tab_width, ' ');
+		}
+		text += '\n';
+	}
+
+	// The usage laid out for a pair of the widths
+	struct UsageText{
+		size_t display_width;
+		size_t tab_width;
+		std::string text;
+	};
+
+	// Definitions of the switches, built only once for each struct type and shared by all its instances
+	struct Schema{
+		caselist_type cases;
+		caseset_type mandatory;
+		const Topion * prototype = nullptr; // the instance holding the default values
+		size_t standalone_min = 0;
+		size_t standalone_max = 0;
+		std::string standalone_argname;
+		bool response_files = false; // "@FILE" is replaced by the arguments in FILE
+		bool abbreviations = false; // a long switch can be given by a prefix of its name matching no other switch
+		size_t independent_cases = 0; // the switches whose converters run in parallel
+		unsigned conversion_threads = 0; // the threads converting them (0 for as many as the hardware threads)
+		bool expand_globs = false; // the standalone parameters with wildcards are replaced by the paths matching them
+		unsigned glob_threads = 0; // the threads reading the directories for them (0 for as many as the hardware threads)
+		std::uint64_t layout = 0; // hash of the definitions, checked when a snapshot is attached
+		PerfectHash long2case;
+		std::vector<size_t> long_names; // positions in "cases" of the keys of "long2case"
+		std::vector<size_t> long_order; // positions in "cases" of the long switches, in the order of the names (for the prefixes)
+		size_t short2case[256];
+#ifdef TOPION_STATS
+		double registration_ns = 0;
+#endif // TOPION_STATS
+
+		// The usage is laid out once for each pair of the widths and kept until the program ends
+		mutable std::mutex usage_mutex;
+		mutable std::vector<std::unique_ptr<const UsageText>> usage_texts;
+		mutable std::atomic<const UsageText *> usage_last{nullptr}; // the one displayed last, found without the lock
+
+		Schema(){
+			std::fill(short2case, short2case + 256, npos);
+		}
+		Schema(const Schema &) = delete;
+		Schema & operator=(const Schema &) = delete;
+
+		size_t find(const char * sw_long, size_t len) const{
+			size_t p = long2case.lookup(sw_long, len);
+			if(p == npos) return npos;
+			p = long_names[p];
+			const std::string & name = cases[p].name_long;
+			if(name.length() != len || std::memcmp(name.data(), sw_long, len) != 0) return npos;
+			return p;
+		}
+
+		size_t find(char sw_short) const{
+			return short2case[static_cast<unsigned char>(sw_short)];
+		}
+
+		// The range in "long_order" of the long switches beginning with "prefix"
+		std::pair<size_t, size_t> prefix_range(const char * prefix, size_t len) const{
+			auto first = std::lower_bound(long_order.begin(), long_order.end(), len, [this, prefix](size_t p, size_t n){
+				return cases[p].name_long.compare(0, n, prefix, n) < 0;
+			});
+			auto last = std::upper_bound(first, long_order.end(), len, [this, prefix](size_t n, size_t p){
+				return cases[p].name_long.compare(0, n, prefix, n) > 0;
+			});
+			return std::make_pair(static_cast<size_t>(first - long_order.begin()), static_cast<size_t>(last - long_order.begin()));
+		}
+
+		// The long switch of the name, or the only one beginning with it if the abbreviations are accepted (npos if none)
+		size_t find_abbreviated(const char * sw_long, size_t len) const{
+			size_t p = find(sw_long, len);
+			if(p != npos || !abbreviations) return p;
+			std::pair<size_t, size_t> range = prefix_range(sw_long, len);
+			return range.second - range.first == 1 ? long_order[range.first] : npos;
+		}
+
+		// Adds the switches beginning with "word" to "candidates" as they are given in the command line
+		// ("--name=" for the long switches receiving a parameter). The long switches are in the order of the names.
+		void complete(const char * word, size_t len, std::vector<std::string> & candidates) const{
+			if(len == 0 || word[0] != '-') return;
+			if(len == 1){
+				for(size_t c = 0; c < 256; ++c){
+					if(short2case[c] != npos) candidates.push_back(std::string("-") + static_cast<char>(c));
+				}
+			}else if(word[1] != '-'){
+				if(len == 2 && find(word[1]) != npos) candidates.push_back(std::string(word, len));
+				return;
+			}
+			if(len > 2 && std::memchr(word + 2, '=', len - 2)) return;
+			std::pair<size_t, size_t> range = len > 2 ? prefix_range(word + 2, len - 2) : std::make_pair(static_cast<size_t>(0), long_order.size());
+			for(size_t i = range.first; i < range.second; ++i){
+				const Case & c = cases[long_order[i]];
+				candidates.push_back("--" + c.name_long + (c.type_name.empty() ? "" : "="));
+			}
+		}
+
+		void add_case(bool is_mandatory, const char * tname, std::ptrdiff_t offset, void (*assign)(void *, const void *), bool (*convert)(const void *, void *, const char *, size_t), const std::shared_ptr<const void> & converter, const char * sw_long, char sw_short, const std::string & desc){
+			Case c(sw_long, sw_short);
+
+			c.offset = offset;
+			c.type_name = tname;
+			c.convert = convert;
+			c.converter = converter;
+			c.assign = assign;
+			c.description = desc;
+			c.default_value = "";
+			c.mandatory = is_mandatory;
+			cases.push_back(c);
+
+			register_name2case(cases.back());
+			if(is_mandatory){
+				mandatory.resize(caseset_words(cases.size()), 0);
+				caseset_insert(mandatory, cases.size() - 1);
+			}
+		}
+
+		void register_name2case(const Case & c){
+			if(c.name_short != '\0'){
+				if(short2case[static_cast<unsigned char>(c.name_short)] != npos){
+					std::stringstream ss;
+					ss << "Switch \"-" << c.name_short << "\" is specified twice.";
+					throw topion_definition_error(ss.str());
+				}
+				short2case[static_cast<unsigned char>(c.name_short)] = cases.size() - 1;
+#ifdef TOPION_DEBUG
+std::cerr << "Added short switch \"-" << c.name_short << "\"" << std::endl;
+#endif
+			}
+#ifdef TOPION_DEBUG
+			if(!(c.name_long.empty())){
+std::cerr << "Added long switch \"--" << c.name_long << "\"" << std::endl;
+			}
+#endif
+		}
+
+		void set_independent(std::ptrdiff_t offset, const char * var){
+			for(auto it = cases.begin(); it != cases.end(); ++it){
+				if(it->offset != offset) continue;
+				if(!(it->independent)){
+					it->independent = true;
+					++independent_cases;
+				}
+				return;
+			}
+			std::stringstream ss;
+			ss << "Variable \"" << var << "\" is not a switch defined before TOPION_INDEPENDENT.";
+			throw topion_definition_error(ss.str());
+		}
+
+		// Called once after all the switches are registered
+		void seal(){
+			std::vector<PerfectHash::key_type> keys;
+			long_names.clear();
+			for(size_t i = 0; i < cases.size(); ++i){
+				if(cases[i].name_long.empty()) continue;
+				keys.emplace_back(cases[i].name_long.data(), cases[i].name_long.length());
+				long_names.push_back(i);
+			}
+			size_t dup = long2case.build(keys);
+			if(dup != npos){
+				std::stringstream ss;
+				ss << "Switch \"--" << cases[long_names[dup]].name_long << "\" is specified twice.";
+				throw topion_definition_error(ss.str());
+			}
+			long_order = long_names;
+			std::sort(long_order.begin(), long_order.end(), [this](size_t a, size_t b){
+				return cases[a].name_long < cases[b].name_long;
+			});
+			layout = layout_hash();
+		}
+
+		const std::string & usage(size_t display_width, size_t tab_width) const{
+			const UsageText * last = usage_last.load(std::memory_order_acquire);
+			if(last && last->display_width == display_width && last->tab_width == tab_width) return last->text;
+
+			std::lock_guard<std::mutex> lock(usage_mutex);
+			for(auto it = usage_texts.begin(); it != usage_texts.end(); ++it){
+				if((*it)->display_width == display_width && (*it)->tab_width == tab_width){
+					usage_last.store(it->get(), std::memory_order_release);
+					return (*it)->text;
+				}
+			}
+			std::unique_ptr<UsageText> u(new UsageText());
+			u->display_width = display_width;
+			u->tab_width = tab_width;
+			u->text = render_usage(display_width, tab_width);
+			usage_texts.emplace_back(std::move(u));
+			usage_last.store(usage_texts.back().get(), std::memory_order_release);
+			return usage_texts.back()->text;
+		}
+
+		std::string render_usage(size_t display_width, size_t tab_width) const{
+			std::string text = "Usage: [PROGRAMNAME] [OPTIONS]";
+			if(!(standalone_argname.empty())){
+				text += ' ';
+				text += standalone_argname;
+			}
+			text += '\n';
+			if(response_files){
+				text += "@FILE in the command line is replaced by the arguments in FILE (one per line).\n";
+			}
+			text += "[OPTIONS] are:\n";
+			std::string head;
+			for(auto it = cases.begin(); it != cases.end(); ++it){
+				head.clear();
+				if(it->name_short != '\0'){
+					head += '-';
+					head += it->name_short;
+				}
+				if(!(it->name_long.empty())){
+					if(it->name_short != '\0') head += ", ";
+					head += "--";
+					head += it->name_long;
+				}
+				if(!(it->type_name.empty())){
+					if(!(it->name_long.empty())) head += '=';
+					head += '[';
+					head += it->type_name;
+					head += ']';
+				}
+				head += ':';
+				append_usage_entry(text, head, it->description, display_width, tab_width);
+			}
+			return text;
+		}
+
+		std::uint64_t layout_hash() const{
+			const std::uint32_t byte_order = 0x01020304;
+			std::uint64_t h = hash_string(reinterpret_cast<const char *>(&byte_order), sizeof(byte_order), snapshot_version);
+			h = hash_mix(h + sizeof(void *));
+			for(auto it = cases.begin(); it != cases.end(); ++it){
+				h = hash_string(it->name_long.data(), it->name_long.length(), h);
+				h = hash_string(it->type_name.data(), it->type_name.length(), h);
+				h = hash_mix(h + static_cast<unsigned char>(it->name_short));
+				h = hash_mix(h + static_cast<std::uint64_t>(it->offset));
+				h = hash_mix(h + it->plain_size);
+				h = hash_mix(h + (it->clear ? 1 : 0));
+			}
+			h = hash_mix(h + standalone_min);
+			h = hash_mix(h + standalone_max);
+			return h;
+		}
+	};
+
+	// Kinds of the errors found when parsing the command line
+	enum class ParseErrorKind{
+		none,
+		short_long_switch, // a long switch of one character (e.g., "--a")
+		undefined_switch,
+		ambiguous_switch, // a prefix of two or more long switches (TOPION_ACCEPT_ABBREVIATIONS)
+		unexpected_parameter, // a parameter given to a switch receiving no parameter
+		missing_parameter,
+		duplicate_switch,
+		unreadable_standalone_file, // the file given to a TopionUtil::StandaloneFile switch
+		unreadable_argument_file, // "@FILE"
+		unterminated_quotation, // in the line given to topion_parse_line
+		invalid_value, // the parameter rejected by the converter
+		missing_mandatory,
+		standalone_count, // the number of the standalone parameters is out of the limit
+		standalone_overflow, // the standalone parameters passed to a sink exceeded the maximum
+		exception // an exception thrown while parsing (e.g., by a converter)
+	};
+
+	// An error found when parsing the command line. The views refer to the parsed arguments or the definitions of the switches.
+	struct ParseError{
+		ParseErrorKind kind;
+		size_t case_id; // the switch in Schema::cases (npos if unknown)
+		size_t position; // the index in argv of the argument (or the "@FILE" containing it), npos if none
+		string_view name; // the switch as specified, without "-" or "--"
+		string_view value; // the parameter, or the file that cannot be read
+		size_t count; // the number of the standalone parameters (standalone_count and standalone_overflow), or the switches matching (ambiguous_switch)
+	};
+
+	// The acceptable number of standalone parameters (for the error messages)
+	inline std::string standalone_range(const Schema & schema){
+		std::stringstream ss;
+		if(schema.standalone_max == 0){
+			ss << "Standalone parameters cannot be accepted";
+		}else if(schema.standalone_min == schema.standalone_max){
+			if(schema.standalone_min == 1){
+				ss << "Just 1 standalone parameter is required";
+			}else{
+				ss << "Just " << schema.standalone_min << " standalone parameters are required";
+			}
+		}else if(schema.standalone_min == 0){
+			ss << "At most " << schema.standalone_max << " standalone parameters can be accepted";
+		}else if(schema.standalone_max == std::numeric_limits<size_t>::max()){
+			if(schema.standalone_min == 1){
+				ss << "At least 1 standalone parameter is required";
+			}else{
+				ss << "At least " << schema.standalone_min << " standalone parameters are required";
+			}
+		}else{
+			ss << "Number of standalone parameters must be between " << schema.standalone_min << " and " << schema.standalone_max << std::endl;
+		}
+		return ss.str();
+	}
+
+	// The result of topion_try_parse: the errors found, formatted into messages only when requested.
+	// It refers to the instance that parsed, and is valid until the instance parses again.
+	class ParseResult{
+	public:
+		ParseResult(const Schema & schema, const buffer_type<ParseError> & errors, const std::exception_ptr & exception) noexcept :
+			schema(&schema), list(&errors), thrown(exception) {}
+
+		// True if the command line is parsed without errors
+		explicit operator bool() const noexcept{
+			return list->empty() && !thrown;
+		}
+
+		// The kind of the first error (ParseErrorKind::exception if an exception was thrown)
+		ParseErrorKind kind() const noexcept{
+			if(thrown) return ParseErrorKind::exception;
+			return list->empty() ? ParseErrorKind::none : list->front().kind;
+		}
+
+		const buffer_type<ParseError> & errors() const noexcept{
+			return *list;
+		}
+
+		// The exception thrown while parsing (null if none), which stopped the parse
+		const std::exception_ptr & exception() const noexcept{
+			return thrown;
+		}
+
+		// The message of an error, e.g., "Switch "x" is not defined."
+		std::string describe(const ParseError & e) const{
+			std::stringstream ss;
+			switch(e.kind){
+			case ParseErrorKind::short_long_switch:
+				ss << "Switch \"" << e.name << "\": long switch must have two or more characters.";
+				break;
+			case ParseErrorKind::undefined_switch:
+				ss << "Switch \"" << e.name << "\" is not defined.";
+				break;
+			case ParseErrorKind::ambiguous_switch:
+				{
+					ss << "Switch \"" << e.name << "\" is ambiguous:";
+					std::pair<size_t, size_t> range = schema->prefix_range(e.name.data(), e.name.length());
+					for(size_t i = range.first; i < range.second; ++i){
+						ss << (i == range.first ? " " : ", ") << "--" << schema->cases[schema->long_order[i]].name_long;
+					}
+					ss << ".";
+				}
+				break;
+			case ParseErrorKind::unexpected_parameter:
+				ss << "Switch \"" << e.name << "\" cannot receive a parameter but specified.";
+				break;
+			case ParseErrorKind::missing_parameter:
+				ss << "Switch \"" << e.name << "\" requires a parameter but not specified.";
+				break;
+			case ParseErrorKind::duplicate_switch:
+				ss << "Switch \"" << e.name << "\" is specified twice or more.";
+				break;
+			case ParseErrorKind::unreadable_standalone_file:
+				ss << "Switch \"" << e.name << "\": Cannot read the file \"" << e.value << "\".";
+				break;
+			case ParseErrorKind::unreadable_argument_file:
+				ss << "Cannot read the file of the arguments \"" << e.value << "\".";
+				break;
+			case ParseErrorKind::unterminated_quotation:
+				ss << "Quotation is not terminated.";
+				break;
+			case ParseErrorKind::invalid_value:
+				ss << switch_label(e.case_id) << ": Value \"" << e.value << "\" is invalid for this switch.";
+				break;
+			case ParseErrorKind::missing_mandatory:
+				ss << switch_label(e.case_id) << " is mandatory but not specified.";
+				break;
+			case ParseErrorKind::standalone_count:
+				ss << standalone_range(*schema) << " (specified " << e.count << ").";
+				break;
+			case ParseErrorKind::standalone_overflow:
+				ss << standalone_range(*schema) << " (specified more than " << e.count << ").";
+				break;
+			default:
+				break;
+			}
+			return ss.str();
+		}
+
+		// The message of all the errors, the same as topion_parsing_error thrown by topion_parse (empty if no error)
+		std::string message() const{
+			std::stringstream ss;
+			if(thrown){
+				try{
+					std::rethrow_exception(thrown);
+				}catch(const std::exception & e){
+					ss << e.what();
+				}catch(...){
+					ss << "Unknown exception";
+				}
+			}else if(list->size() == 1){
+				ss << "An error found when parsing the command line: " << describe(list->front()) << std::endl;
+			}else if(list->size() > 1){
+				ss << list->size() << " errors found when parsing the command line:" << std::endl;
+				for(size_t i = 0; i < list->size(); ++i){
+					ss << "(" << (i+1) << "/" << list->size() << ") " << describe((*list)[i]) << std::endl;
+				}
+			}
+			return ss.str();
+		}
+
+	private:
+		std::string switch_label(size_t case_id) const{
+			const Case & c = schema->cases[case_id];
+			if(!(c.name_long.empty())) return "Switch \"--" + c.name_long + "\"";
+			return std::string("Switch \"-") + c.name_short + "\"";
+		}
+
+		const Schema * schema;
+		const buffer_type<ParseError> * list;
+		std::exception_ptr thrown;
+	};
+
+	// A struct under construction whose switches are being registered into "schema"
+	struct BuildContext{
+		Schema * schema;
+		const Topion * prototype;
+	};
+
+	inline BuildContext * & current_build(){
+		static thread_local BuildContext * context = nullptr;
+		return context;
+	}
+
+	struct BuildScope{
+		BuildContext context;
+		BuildContext * previous;
+
+		BuildScope(Schema & s) : previous(current_build()){
+			context.schema = &s;
+			context.prototype = nullptr;
+			current_build() = &context;
+		}
+		~BuildScope(){
+			finish();
+		}
+		void finish(){
+			if(current_build() == &context) current_build() = previous;
+		}
+	};
+
+	// What an instance knows about the definitions of its switches
+	struct SchemaRef{
+		const Schema * schema = nullptr;
+		Schema * building = nullptr; // Set only in a prototype, while its switches are registered
+	};
+
+	// Holds the schema of "Owner" together with the default-constructed instance it was built from
+	template <class Owner>
+	struct SchemaHolder{
+		Schema schema;
+#ifdef TOPION_STATS
+		StatsClock clock; // started before the prototype is constructed
+#endif // TOPION_STATS
+		BuildScope scope;
+		Owner prototype;
+
+		SchemaHolder() : schema(), scope(schema), prototype(){
+#ifdef TOPION_STATS
+			schema.registration_ns = clock.lap();
+#endif // TOPION_STATS
+			scope.finish();
+			prototype.TOPION_SCHEMA.building = nullptr;
+			schema.prototype = &prototype;
+			schema.seal();
+		}
+	};
+
+	template <class Owner>
+	const Schema & schema_of(){
+		static const SchemaHolder<Owner> holder;
+		return holder.schema;
+	}
+
+	// Lets an instance of "Owner" refer to its schema, and returns the schema under construction if the instance is the prototype
+	template <class Owner>
+	Schema * attach_schema(SchemaRef & schema){
+		if(schema.building == nullptr) schema.schema = &schema_of<Owner>();
+		return schema.building;
+	}
+
+	// Position of "target" counted from the Topion base of "self"
+	template <class Owner, class T>
+	std::ptrdiff_t offset_in(const Owner * self, const T & target){
+		return reinterpret_cast<const char *>(&target) - reinterpret_cast<const char *>(static_cast<const Topion *>(self));
+	}
+
+	template <class T>
+	struct CaseAddition{
+		template <class Owner, class CONV, class DESC>
+		CaseAddition(Owner * self, SchemaRef & schema, bool mandatory, const char * tname, T & target, const CONV & converter, const char * sw_long, char sw_short, const DESC & desc){
+			Schema * building = attach_schema<Owner>(schema);
+			if(building == nullptr) return;
+			add(*building, mandatory, tname, offset_in(self, target), converter, sw_long, sw_short, desc);
+		}
+
+		// Kept out of the constructor so that constructing an instance (not the prototype) stays small
+		template <class CONV, class DESC>
+		TOPION_NOINLINE static void add(Schema & building, bool mandatory, const char * tname, std::ptrdiff_t offset, const CONV & converter, const char * sw_long, char sw_short, const DESC & desc){
+			using conv_type = typename std::decay<CONV>::type;
+			std::shared_ptr<conv_type> kept = std::make_shared<conv_type>(converter);
+			ConverterHooks::prepare(*kept, 0);
+			std::string description(desc);
+			std::string allowed = ConverterHooks::allowed(*kept, 0);
+			if(!allowed.empty()) description = description.empty() ? allowed : description + " (" + allowed + ")";
+			building.add_case(mandatory, tname, offset, Assignment<T>::function(), &Conversion<T, conv_type>::convert, std::shared_ptr<const conv_type>(kept), sw_long, sw_short, description);
+			Case & added = building.cases.back();
+			added.standalone_source = std::is_same<T, StandaloneFile>::value;
+			ConverterHooks::bind(*kept, added.name_long.empty() ? std::string("-") + added.name_short : "--" + added.name_long, 0);
+			building.cases.back().clear = Repetition<T>::function();
+			building.cases.back().plain_size = plain_size<T>();
+			building.cases.back().resolve = Laziness<T>::function();
+		}
+	};
+
+	template <>
 	struct CaseAddition<bool>{
-		CaseAddition(caselist_type & top, name2case_type & tnc, mandatory_list_type & ml, bool mandatory, const char * tname, bool & target, converter_type converter, const std::string & sw_long, char sw_short, const std::string & desc){
-			Case c(sw_long, sw_short);
+		template <class Owner, class CONV, class DESC>
+		CaseAddition(Owner * self, SchemaRef & schema, bool mandatory, const char *, bool & target, const CONV &, const char * sw_long, char sw_short, const DESC & desc){
+			Schema * building = attach_schema<Owner>(schema);
+			if(building == nullptr) return;
+			add(*building, mandatory, offset_in(self, target), sw_long, sw_short, desc);
+		}
+
+		template <class DESC>
+		TOPION_NOINLINE static void add(Schema & building, bool mandatory, std::ptrdiff_t offset, const char * sw_long, char sw_short, const DESC & desc){
+			building.add_case(false, "", offset, Assignment<bool>::function(), nullptr, nullptr, sw_long, sw_short, desc);
+			building.cases.back().plain_size = sizeof(bool);
+
+			// "mandatory" flag should be rejected
+			if(mandatory){
+				std::stringstream ss;
+				ss << "Switch \"" << sw_long << "\": Switch without an argument cannot be mandatory";
+				throw topion_definition_error(ss.str());
+			}
+		}
+	};
+
+	struct StandaloneSetup{
+		template <class Owner, class ARGNAME>
+		StandaloneSetup(Owner *, SchemaRef & schema, size_t newmin, size_t newmax, const ARGNAME & newargname){
+			Schema * building = attach_schema<Owner>(schema);
+			if(building == nullptr) return;
+
+			if(newmin > newmax){
+				std::stringstream ss;
+				ss << "Range of acceptable standalone parameters invalid: minimum = " << newmin << ", maximum = " << newmax;
+				throw topion_definition_error(ss.str());
+			}
+			building->standalone_min = newmin;
+			building->standalone_max = newmax;
+			building->standalone_argname = newargname;
+		}
+	};
+	struct IndependenceSetup{
+		template <class Owner, class T>
+		IndependenceSetup(Owner * self, SchemaRef & schema, const T & target, const char * var){
+			Schema * building = attach_schema<Owner>(schema);
+			if(building == nullptr) return;
+			building->set_independent(offset_in(self, target), var);
+		}
+	};
+
+	struct ConversionThreadSetup{
+		template <class Owner>
+		ConversionThreadSetup(Owner *, SchemaRef & schema, unsigned threads){
+			Schema * building = attach_schema<Owner>(schema);
+			if(building == nullptr) return;
+			building->conversion_threads = threads;
+		}
+	};
+
+	struct AbbreviationSetup{
+		template <class Owner>
+		AbbreviationSetup(Owner *, SchemaRef & schema){
+			Schema * building = attach_schema<Owner>(schema);
+			if(building == nullptr) return;
+			building->abbreviations = true;
+		}
+	};
+
+	struct GlobSetup{
+		template <class Owner>
+		GlobSetup(Owner *, SchemaRef & schema, unsigned threads){
+			Schema * building = attach_schema<Owner>(schema);
+			if(building == nullptr) return;
+			building->expand_globs = true;
+			building->glob_threads = threads;
+		}
+	};
+
+	struct ResponseFileSetup{
+		template <class Owner>
+		ResponseFileSetup(Owner *, SchemaRef & schema){
+			Schema * building = attach_schema<Owner>(schema);
+			if(building == nullptr) return;
+			building->response_files = true;
+		}
+	};
+} // TopionUtil
+
+struct Topion{
+protected:
+	TopionUtil::SchemaRef TOPION_SCHEMA;
+	TopionUtil::buffer_type<TopionUtil::string_view> TOPION_STANDALONES; // refer to argv (or TOPION_FILES)
+	TopionUtil::buffer_type<std::shared_ptr<TopionUtil::FileContent>> TOPION_FILES; // files read by topion_parse
+
+	// Buffers reused by every topion_parse
+	TopionUtil::caseset_type TOPION_SEEN; // the cases given a parameter
+	TopionUtil::buffer_type<char> TOPION_LINE; // the copy of the line given to topion_parse_line, split in place
+	TopionUtil::buffer_type<char *> TOPION_LINE_ARGV; // the words of TOPION_LINE
+	TopionUtil::buffer_type<TopionUtil::Specification> TOPION_SPECIFIED; // cases with a parameter and the parameters, in the order specified
+	TopionUtil::buffer_type<TopionUtil::ParseError> TOPION_ERRORS;
+	std::exception_ptr TOPION_EXCEPTION; // thrown while parsing
+
+#ifdef TOPION_STATS
+	TopionUtil::ParseStats TOPION_STATS_DATA;
+
+	// Records the statistics of one topion_parse from the construction to the destruction (also by an exception)
+	class TopionStatsScope{
+	public:
+		TopionStatsScope(Topion & self) : slowest(TopionUtil::npos), self(self), allocations(TopionUtil::allocation_count()){
+			TopionUtil::ParseStats & stats = self.TOPION_STATS_DATA;
+			stats.registration_ns = self.topion_schema().registration_ns;
+			stats.outline_ns = stats.conversion_ns = stats.error_ns = stats.total_ns = 0;
+			stats.arguments = stats.lookups = stats.conversions = stats.errors = 0;
+			stats.slowest_conversion_ns = 0;
+			self.TOPION_STATS_SCOPE = this;
+		}
+		~TopionStatsScope(){
+			TopionUtil::ParseStats & stats = self.TOPION_STATS_DATA;
+			stats.total_ns = total.lap();
+			stats.allocations = TopionUtil::allocation_count() - allocations;
+			stats.errors = self.TOPION_ERRORS.size();
+
+			// The name is set after the allocations are counted
+			stats.slowest_switch.clear();
+			if(slowest != TopionUtil::npos){
+				const TopionUtil::Case & c = self.topion_schema().cases[slowest];
+				stats.slowest_switch = c.name_long.empty() ? std::string("-") + c.name_short : "--" + c.name_long;
+			}
+			if(TopionUtil::stats_hook()) TopionUtil::stats_hook()(stats);
+		}
+
+		TopionUtil::StatsClock phase;
+		TopionUtil::StatsClock total;
+		size_t slowest; // the case of the slowest conversion
+	private:
+		Topion & self;
+		size_t allocations;
+	};
+	TopionStatsScope * TOPION_STATS_SCOPE = nullptr; // during topion_parse
+#endif // TOPION_STATS
+
+	template <class> friend struct TopionUtil::SchemaHolder;
+
+	const TopionUtil::Schema & topion_schema() const{
+		static const TopionUtil::Schema empty;
+		return TOPION_SCHEMA.schema ? *TOPION_SCHEMA.schema : empty;
+	}
+
+	void * topion_target(const TopionUtil::Case & c){
+		return reinterpret_cast<char *>(this) + c.offset;
+	}
+
+	const void * topion_target(const TopionUtil::Case & c) const{
+		return reinterpret_cast<const char *>(this) + c.offset;
+	}
+
+	// The buffers keep their memory, so that parsing again with an instance allocates nothing
+	void topion_clear_specifications(size_t num_cases, int argc = 0){
+		TOPION_SEEN.assign(TopionUtil::caseset_words(num_cases), 0);
+		if(TOPION_SPECIFIED.capacity() == 0 && argc > 1) TOPION_SPECIFIED.reserve(std::min(static_cast<size_t>(argc - 1), static_cast<size_t>(64)));
+		TOPION_SPECIFIED.clear();
+		TOPION_ERRORS.clear();
+		TOPION_EXCEPTION = nullptr;
+	}
+
+	void topion_error(TopionUtil::ParseErrorKind kind, size_t case_id, size_t position, TopionUtil::string_view name, TopionUtil::string_view value, size_t count = 0){
+		TopionUtil::ParseError e = {kind, case_id, position, name, value, count};
+		TOPION_ERRORS.push_back(e);
+	}
+
+	void topion_add_standalone(const char * s){
+		TOPION_STANDALONES.emplace_back(s);
+	}
+
+	// Whether a standalone parameter is a glob pattern to be expanded (TOPION_EXPAND_GLOBS)
+	bool topion_is_glob(const char * arg) const{
+		return topion_schema().expand_globs && TopionUtil::has_wildcard(arg, arg + std::strlen(arg));
+	}
+
+	// Adds the paths matching a glob pattern as standalone parameters (or the pattern itself if nothing matches),
+	// stopping as soon as they exceed the limit (false then)
+	bool topion_add_standalone_glob(TopionUtil::ArgumentStream & args, const char * pattern){
+		const TopionUtil::Schema & schema = topion_schema();
+		TopionUtil::GlobExpansion glob(pattern);
+		bool matched = glob.run(schema.glob_threads, [&](const std::shared_ptr<TopionUtil::FileContent> & paths){
+			args.keep(paths);
+			TopionUtil::FileArguments entries(*paths);
+			const char * entry;
+			while(entries.next(entry)) topion_add_standalone(entry);
+			return TOPION_STANDALONES.size() <= schema.standalone_max;
+		});
+		if(!matched) topion_add_standalone(pattern);
+		if(TOPION_STANDALONES.size() > schema.standalone_max){
+			topion_error(TopionUtil::ParseErrorKind::standalone_overflow, TopionUtil::npos, args.position(), TopionUtil::string_view(), TopionUtil::string_view(pattern), schema.standalone_max);
+			return false;
+		}
+		return true;
+	}
+
+	// Adds each entry of the file as a standalone parameter (false if the file cannot be read)
+	bool topion_add_standalone_file(TopionUtil::ArgumentStream & args, const char * path){
+		std::shared_ptr<TopionUtil::FileContent> f = args.open_file(path);
+		if(!f) return false;
+		TopionUtil::FileArguments entries(*f);
+		const char * entry;
+		while(entries.next(entry)) topion_add_standalone(entry);
+		return true;
+	}
+
+	// Splits a switch (an argument beginning with '-') into its name and the parameter in the same argument (nullptr if none)
+	static void topion_split_switch(const char * arg, const char * & sw, size_t & sw_len, const char * & direct_param, bool & short_switch){
+		direct_param = nullptr;
+		if(arg[1] == '-'){
+			// Long switch
+			sw = &(arg[2]);
+			short_switch = false;
+			const char * eql = std::strchr(&(arg[2]), '=');
+			if(eql){
+				sw_len = eql - &(arg[2]);
+				direct_param = eql + 1;
+			}else{
+				sw_len = std::strlen(sw);
+			}
+		}else{
+			// Short switch
+			sw = &(arg[1]);
+			sw_len = 1;
+			short_switch = true;
+			if(arg[2] != '\0'){
+				direct_param = &(arg[2]);
+			}
+		}
+	}
+
+	// Parses the switches and their parameters. The standalone parameters are kept,
+	// or only counted if "count" is given (then the files of standalone parameters are opened but not read).
+	// If "head" is given, the parse stops at the first standalone parameter and stores its position there.
+	// Returns false if the parse ended midway.
+	bool topion_parse_outline(TopionUtil::ArgumentStream & args, TopionUtil::StandaloneCount * count, size_t * head = nullptr){
+		using TopionUtil::ParseErrorKind;
+		const TopionUtil::Schema & schema = topion_schema();
+		bool switch_ended = false;
+		const char * arg;
+		while(args.next(arg)){
+#ifdef TOPION_STATS
+			++TOPION_STATS_DATA.arguments;
+#endif // TOPION_STATS
+			if(!switch_ended && arg[0] == '-'){
+				const char * sw; // the switch name (not null-terminated)
+				size_t sw_len;
+				const char * direct_param; // the parameter for the switch, without separated by spaces
+				bool short_switch;
+				topion_split_switch(arg, sw, sw_len, direct_param, short_switch);
+				TopionUtil::string_view name(sw, sw_len);
+				if(sw_len == 0){
+					switch_ended = true;
+					args.stop_expansion();
+					continue;
+				}else if(!short_switch && sw_len == 1){
+					topion_error(ParseErrorKind::short_long_switch, TopionUtil::npos, args.position(), name, TopionUtil::string_view());
+					return false;
+				}
+
+				size_t case_id = short_switch ? schema.find(sw[0]) : schema.find_abbreviated(sw, sw_len);
+#ifdef TOPION_STATS
+				++TOPION_STATS_DATA.lookups;
+#endif // TOPION_STATS
+				if(case_id == TopionUtil::npos){
+					size_t matching = 0;
+					if(schema.abbreviations && !short_switch){
+						std::pair<size_t, size_t> range = schema.prefix_range(sw, sw_len);
+						matching = range.second - range.first;
+					}
+					if(matching > 1){
+						topion_error(ParseErrorKind::ambiguous_switch, TopionUtil::npos, args.position(), name, TopionUtil::string_view(), matching);
+					}else{
+						topion_error(ParseErrorKind::undefined_switch, TopionUtil::npos, args.position(), name, TopionUtil::string_view());
+					}
+					return false;
+				}
+				const TopionUtil::Case & c = schema.cases[case_id];
+
+				if(c.type_name.empty()){
+					if(direct_param){
+						topion_error(ParseErrorKind::unexpected_parameter, case_id, args.position(), name, TopionUtil::string_view(direct_param));
+					}
+					*(static_cast<bool *>(topion_target(c))) = true;
+#ifdef TOPION_DEBUG
+					std::cout << "SWITCH " << std::string(sw, sw_len) << " TRUE" << std::endl;
+#endif // TOPION_DEBUG
+				}else{
+					// Where is the parameter?
+					size_t position = args.position();
+					const char * param = direct_param;
+					if(param == nullptr && !args.next(param)){
+						if(args.failed_file() == nullptr){
+							topion_error(ParseErrorKind::missing_parameter, case_id, position, name, TopionUtil::string_view());
+							return false;
+						}
+						break; // reported below
+					}
+					if(!TopionUtil::caseset_test(TOPION_SEEN, case_id) || c.clear != nullptr){
+						TopionUtil::Specification s = {case_id, param, position};
+						TOPION_SPECIFIED.push_back(s);
+					}else{
+						topion_error(ParseErrorKind::duplicate_switch, case_id, position, name, TopionUtil::string_view(param));
+					}
+					TopionUtil::caseset_insert(TOPION_SEEN, case_id);
+
+	#ifdef TOPION_DEBUG
+					std::cout << "SWITCH " << std::string(sw, sw_len) << " VALUE " << param << std::endl;
+	#endif // TOPION_DEBUG
+
+					if(c.standalone_source){
+						bool opened;
+						if(count){
+							opened = static_cast<bool>(args.open_file(param));
+							count->partial = true;
+						}else{
+							opened = topion_add_standalone_file(args, param);
+						}
+						if(!opened){
+							topion_error(ParseErrorKind::unreadable_standalone_file, case_id, position, name, TopionUtil::string_view(param));
+							return false;
+						}
+					}
+				}
+			}else if(head){
+				*head = args.position();
+				return true;
+			}else if(count){
+				++(count->num);
+				if(topion_is_glob(arg)) count->partial = true;
+			}else if(topion_is_glob(arg)){
+				if(!topion_add_standalone_glob(args, arg)) return false;
+			}else{
+				topion_add_standalone(arg);
+			}
+		}
+		if(args.failed_file() != nullptr){
+			topion_error(ParseErrorKind::unreadable_argument_file, TopionUtil::npos, args.position(), TopionUtil::string_view(), TopionUtil::string_view(args.failed_file()));
+			return false;
+		}
+		return true;
+	}
+
+	void topion_check_standalones(size_t num){
+		const TopionUtil::Schema & schema = topion_schema();
+		if(num < schema.standalone_min || num > schema.standalone_max){
+			topion_error(TopionUtil::ParseErrorKind::standalone_count, TopionUtil::npos, TopionUtil::npos, TopionUtil::string_view(), TopionUtil::string_view(), num);
+		}
+	}
+
+	// Passes a standalone parameter to the sink of topion_parse, failing as soon as too many are given
+	template <class SINK>
+	bool topion_pass_standalone(SINK & sink, TopionUtil::string_view standalone, size_t & num, size_t position){
+		if(num == topion_schema().standalone_max){
+			topion_error(TopionUtil::ParseErrorKind::standalone_overflow, TopionUtil::npos, position, TopionUtil::string_view(), standalone, num);
+			return false;
+		}
+		++num;
+		sink(standalone);
+		return true;
+	}
+
+	// Splits a line into the arguments in TOPION_LINE and parses them
+	void topion_run_line(TopionUtil::string_view line) noexcept{
+		try{
+			static char program[] = "";
+			TOPION_LINE.assign(line.data(), line.data() + line.size());
+			TOPION_LINE.push_back('\0');
+			TOPION_LINE_ARGV.clear();
+			TOPION_LINE_ARGV.push_back(program);
+			if(!TopionUtil::split_words(TOPION_LINE.data(), TOPION_LINE.data() + line.size(), TOPION_LINE_ARGV)){
+				topion_clear_specifications(topion_schema().cases.size());
+				topion_error(TopionUtil::ParseErrorKind::unterminated_quotation, TopionUtil::npos, TopionUtil::npos, TopionUtil::string_view(), TopionUtil::string_view());
+				return;
+			}
+			TOPION_LINE_ARGV.push_back(nullptr);
+			topion_run(static_cast<int>(TOPION_LINE_ARGV.size() - 1), TOPION_LINE_ARGV.data());
+		}catch(...){
+			TOPION_EXCEPTION = std::current_exception();
+		}
+	}
+
+	// Converts the parameters of the switches, and checks the mandatory switches
+	void topion_parse_values(){
+		topion_convert_values();
+		topion_check_mandatory();
+	}
+
+	void topion_convert_values(){
+		const TopionUtil::Schema & schema = topion_schema();
+		// The switches that can be repeated add the parameters to the value, after the default value is cleared
+		for(auto it = TOPION_SPECIFIED.begin(); it != TOPION_SPECIFIED.end(); ++it){
+			const TopionUtil::Case & c = schema.cases[it->case_id];
+			if(c.clear) c.clear(topion_target(c));
+		}
+		if(schema.independent_cases > 1 && topion_independent_groups()){
+			topion_convert_values_parallel();
+			return;
+		}
+
+		for(auto it = TOPION_SPECIFIED.begin(); it != TOPION_SPECIFIED.end(); ++it){
+			const TopionUtil::Case & c = schema.cases[it->case_id];
+			size_t len = std::strlen(it->value);
+#ifdef TOPION_STATS
+			TopionUtil::StatsClock conversion;
+			bool converted = c.convert(c.converter.get(), topion_target(c), it->value, len);
+			double ns = conversion.lap();
+			++TOPION_STATS_DATA.conversions;
+			if(ns > TOPION_STATS_DATA.slowest_conversion_ns){
+				TOPION_STATS_DATA.slowest_conversion_ns = ns;
+				TOPION_STATS_SCOPE->slowest = it->case_id;
+			}
+			if(!converted){
+#else
+			if(!(c.convert(c.converter.get(), topion_target(c), it->value, len))){
+#endif // TOPION_STATS
+				topion_error(TopionUtil::ParseErrorKind::invalid_value, it->case_id, it->position, topion_switch_name(c), TopionUtil::string_view(it->value, len));
+			}
+		}
+	}
+
+	// Whether two or more different independent switches are specified, which is worth starting threads for
+	// (the threads are started by every topion_parse, so one slow switch is converted by this thread with the others)
+	bool topion_independent_groups() const{
+		const TopionUtil::Schema & schema = topion_schema();
+		size_t first = TopionUtil::npos;
+		for(auto it = TOPION_SPECIFIED.begin(); it != TOPION_SPECIFIED.end(); ++it){
+			if(!(schema.cases[it->case_id].independent)) continue;
+			if(first == TopionUtil::npos){
+				first = it->case_id;
+			}else if(it->case_id != first){
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Converts the parameters of the independent switches on threads started for this parse, while this thread converts the others in order.
+	// The parameters of a switch given repeatedly are converted in order by one thread.
+	// The errors are recorded in the order of the arguments, and the exception thrown for the earliest argument is rethrown,
+	// as if the parameters were converted one by one.
+	void topion_convert_values_parallel(){
+		const TopionUtil::Schema & schema = topion_schema();
+		size_t n = TOPION_SPECIFIED.size();
+		std::vector<size_t> dependent; // positions in TOPION_SPECIFIED
+		std::vector<size_t> independent; // positions in TOPION_SPECIFIED, grouped by the switch
+		for(size_t i = 0; i < n; ++i){
+			if(schema.cases[TOPION_SPECIFIED[i].case_id].independent){
+				independent.push_back(i);
+			}else{
+				dependent.push_back(i);
+			}
+		}
+		std::stable_sort(independent.begin(), independent.end(), [this](size_t a, size_t b){
+			return TOPION_SPECIFIED[a].case_id < TOPION_SPECIFIED[b].case_id;
+		});
+		std::vector<size_t> groups; // the beginnings of the groups in "independent", followed by its end
+		for(size_t i = 0; i < independent.size(); ++i){
+			if(i == 0 || TOPION_SPECIFIED[independent[i]].case_id != TOPION_SPECIFIED[independent[i-1]].case_id) groups.push_back(i);
+		}
+		groups.push_back(independent.size());
+
+		std::vector<TopionUtil::ConversionOutcome> outcomes(n);
+		// Converts the parameters at the positions in order, until a converter throws an exception
+		auto convert = [this, &schema, &outcomes](const size_t * first, const size_t * last){
+			for(const size_t * p = first; p != last; ++p){
+				const TopionUtil::Specification & s = TOPION_SPECIFIED[*p];
+				const TopionUtil::Case & c = schema.cases[s.case_id];
+				TopionUtil::ConversionOutcome & o = outcomes[*p];
+				try{
+#ifdef TOPION_STATS
+					TopionUtil::StatsClock conversion;
+					o.converted = c.convert(c.converter.get(), topion_target(c), s.value, std::strlen(s.value));
+					o.ns = conversion.lap();
+					o.run = true;
+#else
+					o.converted = c.convert(c.converter.get(), topion_target(c), s.value, std::strlen(s.value));
+#endif // TOPION_STATS
+				}catch(...){
+					o.thrown = std::current_exception();
+					return;
+				}
+			}
+		};
+
+		size_t num_groups = groups.size() - 1;
+		TopionUtil::WorkQueue queue(num_groups, 1);
+		unsigned threads = TopionUtil::worker_count(schema.conversion_threads, num_groups + (dependent.empty() ? 0 : 1));
+		TopionUtil::run_workers(threads, [&](unsigned id){
+			if(id == 0) convert(dependent.data(), dependent.data() + dependent.size());
+			size_t first, last;
+			while(queue.next(first, last)){
+				for(size_t g = first; g < last; ++g) convert(independent.data() + groups[g], independent.data() + groups[g+1]);
+			}
+		});
+
+		for(size_t i = 0; i < n; ++i){
+			const TopionUtil::Specification & s = TOPION_SPECIFIED[i];
+			const TopionUtil::ConversionOutcome & o = outcomes[i];
+#ifdef TOPION_STATS
+			if(o.run){
+				++TOPION_STATS_DATA.conversions;
+				if(o.ns > TOPION_STATS_DATA.slowest_conversion_ns){
+					TOPION_STATS_DATA.slowest_conversion_ns = o.ns;
+					TOPION_STATS_SCOPE->slowest = s.case_id;
+				}
+			}
+#endif // TOPION_STATS
+			if(o.thrown) std::rethrow_exception(o.thrown);
+			if(!(o.converted)){
+				const TopionUtil::Case & c = schema.cases[s.case_id];
+				topion_error(TopionUtil::ParseErrorKind::invalid_value, s.case_id, s.position, topion_switch_name(c), TopionUtil::string_view(s.value, std::strlen(s.value)));
+			}
+		}
+	}
+
+	void topion_check_mandatory(){
+		const TopionUtil::Schema & schema = topion_schema();
+		// 64 switches at once
+		for(size_t w = 0; w < schema.mandatory.size(); ++w){
+			std::uint64_t missing = schema.mandatory[w] & ~TOPION_SEEN[w];
+			for(size_t b = 0; missing != 0; ++b, missing >>= 1){
+				if(!(missing & 1)) continue;
+				size_t case_id = (w << 6) + b;
+				topion_error(TopionUtil::ParseErrorKind::missing_mandatory, case_id, TopionUtil::npos, topion_switch_name(schema.cases[case_id]), TopionUtil::string_view());
+			}
+		}
+	}
+
+	// The name of the switch for the errors not tied to an argument (the long one if defined)
+	static TopionUtil::string_view topion_switch_name(const TopionUtil::Case & c){
+		if(!(c.name_long.empty())) return TopionUtil::string_view(c.name_long);
+		return TopionUtil::string_view(&(c.name_short), 1);
+	}
+
+	// Parses the command line, recording the errors and the exception thrown (if any) instead of throwing them
+	void topion_run(int argc, char ** argv) noexcept{
+		try{
+			const TopionUtil::Schema & schema = topion_schema();
+			topion_clear_specifications(schema.cases.size(), argc);
+
+			TopionUtil::ArgumentStream args(argc, argv, schema.response_files, TOPION_FILES);
+			bool outlined = topion_parse_outline(args, nullptr);
+#ifdef TOPION_STATS
+			TOPION_STATS_DATA.outline_ns = TOPION_STATS_SCOPE->phase.lap();
+#endif // TOPION_STATS
+			if(outlined){
+				topion_check_standalones(TOPION_STANDALONES.size());
+				topion_parse_values();
+			}
+#ifdef TOPION_STATS
+			TOPION_STATS_DATA.conversion_ns = TOPION_STATS_SCOPE->phase.lap();
+#endif // TOPION_STATS
+		}catch(...){
+			TOPION_EXCEPTION = std::current_exception();
+		}
+	}
+
+	template <class SINK>
+	void topion_run(int argc, char ** argv, SINK & sink) noexcept{
+		try{
+			const TopionUtil::Schema & schema = topion_schema();
+			topion_clear_specifications(schema.cases.size(), argc);
+
+			TopionUtil::ArgumentStream args(argc, argv, schema.response_files, TOPION_FILES);
+			TopionUtil::StandaloneCount count;
+			bool outlined = topion_parse_outline(args, &count);
+#ifdef TOPION_STATS
+			TOPION_STATS_DATA.outline_ns = TOPION_STATS_SCOPE->phase.lap();
+#endif // TOPION_STATS
+			if(outlined){
+				if(!count.partial || count.num > schema.standalone_max){
+					topion_check_standalones(count.num);
+				}
+				topion_parse_values();
+			}
+#ifdef TOPION_STATS
+			TOPION_STATS_DATA.conversion_ns = TOPION_STATS_SCOPE->phase.lap();
+#endif // TOPION_STATS
+			if(!(TOPION_ERRORS.empty())) return;
+
+			// ------------------------------------------------------------
+			// Pass the standalone parameters
+			// ------------------------------------------------------------
+			// The switches are already checked, so that they are only skipped here
+			size_t num = 0;
+			bool switch_ended = false;
+			const char * arg;
+			args.rewind();
+			while(args.next(arg)){
+				TopionUtil::string_view standalone;
+				if(!switch_ended && arg[0] == '-'){
+					const char * sw;
+					size_t sw_len;
+					const char * param;
+					bool short_switch;
+					topion_split_switch(arg, sw, sw_len, param, short_switch);
+					if(sw_len == 0){
+						switch_ended = true;
+						args.stop_expansion();
+						continue;
+					}
+					const TopionUtil::Case & c = schema.cases[short_switch ? schema.find(sw[0]) : schema.find_abbreviated(sw, sw_len)];
+					if(c.type_name.empty()) continue;
+					size_t position = args.position();
+					if(param == nullptr) args.next(param);
+					if(!c.standalone_source) continue;
+
+					// The file is released after all its entries are passed
+					std::shared_ptr<TopionUtil::FileContent> f = args.open_file(param);
+					TopionUtil::FileArguments entries(*f);
+					while(entries.next(standalone)){
+						if(!topion_pass_standalone(sink, standalone, num, position)) return;
+					}
+					continue;
+				}
+				if(topion_is_glob(arg)){
+					// The paths are released after they are passed
+					size_t position = args.position();
+					bool passed = true;
+					TopionUtil::GlobExpansion glob(arg);
+					bool matched = glob.run(schema.glob_threads, [&](const std::shared_ptr<TopionUtil::FileContent> & paths){
+						TopionUtil::FileArguments entries(*paths);
+						while(passed && entries.next(standalone)){
+							passed = topion_pass_standalone(sink, standalone, num, position);
+						}
+						return passed;
+					});
+					if(!passed) return;
+					if(matched) continue;
+				}
+				standalone = TopionUtil::string_view(arg);
+				if(!topion_pass_standalone(sink, standalone, num, args.position())) return;
+			}
+			if(num < schema.standalone_min){
+				topion_check_standalones(num);
+			}
+		}catch(...){
+			TOPION_EXCEPTION = std::current_exception();
+		}
+	}
+
+	static std::uint64_t topion_snapshot_align(std::uint64_t n){
+		return (n + 7) & ~static_cast<std::uint64_t>(7);
+	}
 
-			c.target = (void *)(&target);
-			c.type_name = "";
-			c.conv = converter;
-			c.description = desc;
-			c.default_value = "";
-			top.push_back(c);
+	TopionUtil::ParseResult topion_result() const noexcept{
+		return TopionUtil::ParseResult(topion_schema(), TOPION_ERRORS, TOPION_EXCEPTION);
+	}
 
-			register_name2case(top, tnc, c.name_long, c.name_short, top.size() - 1);
-			// "mandatory" flag should be rejected
-			if(mandatory){
-				std::stringstream ss;
-				ss << "Switch \"" << sw_long << "\": Switch without an argument cannot be mandatory";
-				throw topion_definition_error(ss.str());
-			}
+	// Whether the parameters given to a switch given repeatedly are the same as the ones in "before"
+	bool topion_same_parameters(size_t case_id, const Topion & before) const{
+		auto a = TOPION_SPECIFIED.begin();
+		auto b = before.TOPION_SPECIFIED.begin();
+		for(;;){
+			while(a != TOPION_SPECIFIED.end() && a->case_id != case_id) ++a;
+			while(b != before.TOPION_SPECIFIED.end() && b->case_id != case_id) ++b;
+			if(a == TOPION_SPECIFIED.end() || b == before.TOPION_SPECIFIED.end()) break;
+			if(std::strcmp(a->value, b->value) != 0) return false;
+			++a;
+			++b;
 		}
-	};
+		return a == TOPION_SPECIFIED.end() && b == before.TOPION_SPECIFIED.end();
+	}
 
-	struct StandaloneSetup{
-		StandaloneSetup(size_t & curmin, size_t & curmax, std::string & curargname, size_t newmin, size_t newmax, const std::string & newargname){
-			if(newmin > newmax){
-				std::stringstream ss;
-				ss << "Range of acceptable standalone parameters invalid: minimum = " << newmin << ", maximum = " << newmax;
-				throw topion_definition_error(ss.str());
-			}
-			curmin = newmin;
-			curmax = newmax;
-			curargname = newargname;
+	// Throws the exception thrown while parsing, or topion_parsing_error with the message of the errors
+	void topion_throw_errors(){
+		if(TOPION_EXCEPTION) std::rethrow_exception(TOPION_EXCEPTION);
+		if(!(TOPION_ERRORS.empty())){
+#ifdef TOPION_STATS
+			TopionUtil::StatsClock formatting;
+			std::string message = topion_result().message();
+			TOPION_STATS_DATA.error_ns = formatting.lap();
+			throw topion_parsing_error(message);
+#else
+			throw topion_parsing_error(topion_result().message());
+#endif // TOPION_STATS
 		}
-	};
-} // TopionUtil
+	}
+
+	void topion_attach_build(){
+		// The first Topion constructed while building a schema is the prototype of the struct
+		TopionUtil::BuildContext * b = TopionUtil::current_build();
+		if(b != nullptr && b->prototype == nullptr){
+			b->prototype = this;
+			TOPION_SCHEMA.schema = b->schema;
+			TOPION_SCHEMA.building = b->schema;
+		}
+	}
 
-struct Topion{
-protected:
-	TopionUtil::caselist_type TOPION_CASES;
-	TopionUtil::name2case_type TOPION_NAME2CASE;
-	TopionUtil::mandatory_list_type TOPION_MANDATORY;
-	std::deque<std::string> TOPION_STANDALONES;
-	size_t TOPION_STANDALONE_MIN = 0;
-	size_t TOPION_STANDALONE_MAX = 0;
-	std::string TOPION_STANDALONE_ARGNAME;
 public:
+	Topion(){
+		topion_attach_build();
+	}
+
+	// The buffers of the instance (the standalone parameters, the files and the lines read, and those reused by
+	// every topion_parse) are allocated from "memory", e.g., a TopionUtil::MonotonicArena living as long as the instance.
+	// The struct takes it by "using Topion::Topion;".
+	explicit Topion(TopionUtil::MemoryResource * memory) :
+		TOPION_STANDALONES(memory), TOPION_FILES(memory), TOPION_SEEN(memory), TOPION_LINE(memory),
+		TOPION_LINE_ARGV(memory), TOPION_SPECIFIED(memory), TOPION_ERRORS(memory){
+		topion_attach_build();
+	}
+
 	template <class IO>
 	void topion_usage(IO & out, size_t display_width, size_t tab_width){
 		if(display_width <= tab_width){
 			throw topion_definition_error("For 'usage', 'display_width' must be larger than 'tab_width'");
 		}
 
-		out << "Usage: [PROGRAMNAME] [OPTIONS]";
-		if(!(TOPION_STANDALONE_ARGNAME.empty())){
-			out << " " << TOPION_STANDALONE_ARGNAME;
-		}
-		out << std::endl;
-		out << "[OPTIONS] are:" << std::endl;
-		for(auto it = TOPION_CASES.begin(); it != TOPION_CASES.end(); ++it){
-			std::stringstream head;
-			if(it->name_short != '\0'){
-				head << "-" << it->name_short;
-			}
-			if(!(it->name_long.empty())){
-				if(it->name_short != '\0') head << ", ";
-				head << "--" << it->name_long;
-			}
-			if(!(it->type_name.empty())){
-				if(!(it->name_long.empty())) head << "=";
-				head << "[" << it->type_name << "]";
-			}
-			head << ":";
+		// Laid out only for the first time, and written at once
+		out << topion_schema().usage(display_width, tab_width) << std::flush;
+	}
 
-			// Option name
-			out << head.str();
-			if(head.str().length() < tab_width){
-				for(size_t i = head.str().length(); i < tab_width; ++i) out << ' ';
-			}else{
-				out << std::endl;
-				for(size_t i = 0; i < tab_width; ++i) out << ' ';
-			}
+	template <class IO>
+	void topion_usage(IO & out){
+		topion_usage(out, 70, 20);
+	}
 
-			// Description
-			size_t displayed = 0;
-			for(size_t p = 0; p < it->description.length(); ++p){
-				if(displayed == display_width - tab_width || it->description[p] == '\n'){
-					out << std::endl;
-					for(size_t i = 0; i < tab_width; ++i) out << ' ';
-					displayed = 0;
-				}
-				if(it->description[p] != '\n'){
-					out << it->description[p];
-					++displayed;
-				}
+	// Adds the switches beginning with "word" (e.g., "--tr" or "-") to "candidates", for the completion by shells
+	void topion_complete(TopionUtil::string_view word, std::vector<std::string> & candidates) const{
+		topion_schema().complete(word.data(), word.length(), candidates);
+	}
+
+	// Answers the queries from the completion scripts, returning true if the command line is one of them
+	// (then the program should exit without parsing it):
+	//   "PROGRAM --topion-complete WORD" displays the switches beginning with WORD, one per line;
+	//   "PROGRAM --topion-completion-script SHELL" displays the completion script for SHELL ("bash" or "zsh").
+	template <class IO>
+	bool topion_completion(int argc, char ** argv, IO & out) const{
+		if(argc < 2) return false;
+		if(std::strcmp(argv[1], "--topion-complete") == 0){
+			std::vector<std::string> candidates;
+			if(argc > 2) topion_complete(TopionUtil::string_view(argv[2]), candidates);
+			std::string text;
+			for(auto it = candidates.begin(); it != candidates.end(); ++it){
+				text += *it;
+				text += '\n';
 			}
-			out << std::endl;
+			out << text << std::flush;
+			return true;
 		}
+		if(std::strcmp(argv[1], "--topion-completion-script") == 0){
+			const char * program = argv[0];
+			const char * slash = std::strrchr(program, '/');
+			if(slash) program = slash + 1;
+			topion_completion_script(out, program, argc > 2 ? argv[2] : "bash");
+			return true;
+		}
+		return false;
 	}
 
+	// Displays the script completing the switches of "program" by "shell" ("bash" or "zsh"), which queries the program by "--topion-complete"
 	template <class IO>
-	void topion_usage(IO & out){
-		topion_usage(out, 70, 20);
+	static void topion_completion_script(IO & out, const std::string & program, const std::string & shell){
+		std::string function = "_topion_complete_";
+		for(size_t i = 0; i < program.length(); ++i){
+			function += std::isalnum(static_cast<unsigned char>(program[i])) ? program[i] : '_';
+		}
+		std::stringstream ss;
+		if(shell == "bash"){
+			ss << function << "(){" << std::endl;
+			ss << "\tlocal IFS=$'\\n'" << std::endl;
+			ss << "\tCOMPREPLY=($(\"${COMP_WORDS[0]}\" --topion-complete \"${COMP_WORDS[COMP_CWORD]}\" 2>/dev/null))" << std::endl;
+			ss << "\tif [[ ${#COMPREPLY[@]} -eq 1 && ${COMPREPLY[0]} == *= ]]; then compopt -o nospace; fi" << std::endl;
+			ss << "}" << std::endl;
+			ss << "complete -o default -F " << function << " " << program << std::endl;
+		}else if(shell == "zsh"){
+			ss << "#compdef " << program << std::endl;
+			ss << function << "(){" << std::endl;
+			ss << "\tlocal -a candidates" << std::endl;
+			ss << "\tcandidates=(${(f)\"$(\"${words[1]}\" --topion-complete \"${words[CURRENT]}\" 2>/dev/null)\"})" << std::endl;
+			ss << "\tif (( ${#candidates} == 0 )); then" << std::endl;
+			ss << "\t\t_files" << std::endl;
+			ss << "\t\treturn" << std::endl;
+			ss << "\tfi" << std::endl;
+			ss << "\tcompadd -S '' -- ${(M)candidates:#*=}" << std::endl;
+			ss << "\tcompadd -- ${candidates:#*=}" << std::endl;
+			ss << "}" << std::endl;
+			ss << "compdef " << function << " " << program << std::endl;
+		}else{
+			ss << "Completion for the shell \"" << shell << "\" is not supported (\"bash\" or \"zsh\")." << std::endl;
+			throw topion_parsing_error(ss.str());
+		}
+		out << ss.str() << std::flush;
 	}
 
 	void topion_parse(int argc, char ** argv){
-		std::deque<std::string> errors;
-		TopionUtil::specification_type specifications;
+#ifdef TOPION_STATS
+		TopionStatsScope stats(*this);
+#endif // TOPION_STATS
+		topion_run(argc, argv);
+		topion_throw_errors();
+	}
 
-		// ------------------------------------------------------------
-		// Parse the outline
-		// ------------------------------------------------------------
-		bool switch_ended = false;
-		bool parse_ended_midway = false;
-		for(int i = 1; i < argc; ++i){
-			if(!switch_ended && argv[i][0] == '-'){
-				std::string sw;
-				char * direct_param = nullptr; // the parameter for the switch, without separated by spaces
-				bool short_switch = false;
-				if(argv[i][1] == '-'){
-					// Long switch
-					char * eql = std::strchr(&(argv[i][2]), '=');
-					if(eql){
-						sw.assign(&(argv[i][2]), eql - &(argv[i][2]));
-						direct_param = eql + 1;
-					}else{
-						sw.assign(&(argv[i][2]));
-					}
+	// Parses the command line like above, but passes each standalone parameter to "sink" (called with a TopionUtil::string_view)
+	// in order instead of keeping it, so that the program can process it while the rest are still being read.
+	// The switches are all checked and converted before "sink" is called first. The number of the standalone parameters
+	// is checked then as far as known (the entries of the files of standalone parameters are counted while passed),
+	// and topion_parsing_error is thrown as soon as it exceeds the maximum.
+	template <class SINK>
+	void topion_parse(int argc, char ** argv, SINK sink){
+#ifdef TOPION_STATS
+		TopionStatsScope stats(*this);
+#endif // TOPION_STATS
+		topion_run(argc, argv, sink);
+		topion_throw_errors();
+	}
 
-					if(sw.empty()){
-						switch_ended = true;
-						continue;
-					}else if(sw.length() == 1){
-						std::stringstream ss;
-						ss << "Switch \"" << sw << "\": long switch must have two or more characters.";
-						errors.push_back(ss.str());
-						parse_ended_midway = true;
-						break;
-					}
-				}else{
-					// Short switch
-					sw.assign(1, argv[i][1]);
-					short_switch = true;
-					if(argv[i][2] != '\0'){
-						direct_param = &(argv[i][2]);
-					}
-				}
+	// Converts the parameters kept by the Lazy variables now, raising topion_parsing_error listing the invalid ones
+	// (for the programs failing fast as if the variables were not Lazy)
+	void topion_validate_all(){
+		const TopionUtil::Schema & schema = topion_schema();
+		TOPION_ERRORS.clear();
+		TOPION_EXCEPTION = nullptr;
+		for(auto it = TOPION_SPECIFIED.begin(); it != TOPION_SPECIFIED.end(); ++it){
+			const TopionUtil::Case & c = schema.cases[it->case_id];
+			if(c.resolve && !(c.resolve(topion_target(c)))){
+				topion_error(TopionUtil::ParseErrorKind::invalid_value, it->case_id, it->position, topion_switch_name(c), TopionUtil::string_view(it->value));
+			}
+		}
+		topion_throw_errors();
+	}
 
-				auto f = TOPION_NAME2CASE.find(sw);
-				if(f == TOPION_NAME2CASE.end()){
-					std::stringstream ss;
-					ss << "Switch \"" << sw << "\" is not defined.";
-					errors.push_back(ss.str());
-					parse_ended_midway = true;
-					break;
-				}
-				size_t case_id = f->second;
-				TopionUtil::Case & c = TOPION_CASES[case_id];
+	// Parses only the switches before the first standalone parameter (e.g., the name of a subcommand), and returns
+	// the index in argv of the standalone parameter (argc if none). The standalone parameters are not checked, and "@FILE" is not replaced.
+	int topion_parse_head(int argc, char ** argv){
+#ifdef TOPION_STATS
+		TopionStatsScope stats(*this);
+#endif // TOPION_STATS
+		const TopionUtil::Schema & schema = topion_schema();
+		topion_clear_specifications(schema.cases.size());
 
-				if(c.type_name.empty()){
-					if(direct_param){
-						std::stringstream ss;
-						ss << "Switch \"" << sw << "\" cannot receive a parameter but specified.";
-						errors.push_back(ss.str());
-					}
-					*(static_cast<bool *>(c.target)) = true;
-#ifdef TOPION_DEBUG
-					std::cout << "SWITCH " << sw << " TRUE" << std::endl;
-#endif // TOPION_DEBUG
-				}else{
-					// Where is the parameter?
-					if(specifications.find(case_id) != specifications.end()){
-						std::stringstream ss;
-						ss << "Switch \"" << sw << "\" is specified twice or more.";
-						errors.push_back(ss.str());
-					}
-					if(direct_param){
-						specifications[case_id] = direct_param;
-					}else{
-						if(c.type_name.empty()){
-							specifications[case_id] = "";
-						}else{
-							if(i == argc - 1){
-								std::stringstream ss;
-								ss << "Switch \"" << sw << "\" requires a parameter but not specified.";
-								errors.push_back(ss.str());
-								parse_ended_midway = true;
-								break;
-							}
-							++i;
-							specifications[case_id] = argv[i];
-						}
-					}
+		TopionUtil::ArgumentStream args(argc, argv, false, TOPION_FILES);
+		size_t head = static_cast<size_t>(argc);
+		if(topion_parse_outline(args, nullptr, &head)) topion_parse_values();
+		topion_throw_errors();
+		return static_cast<int>(head);
+	}
 
-	#ifdef TOPION_DEBUG
-					std::cout << "SWITCH " << sw << " VALUE " << specifications[case_id] << std::endl;
-	#endif // TOPION_DEBUG
-				}
-			}else{
-				TOPION_STANDALONES.emplace_back(argv[i]);
-			}
-		}
+	// Parses the command line like topion_parse, but returns the errors instead of throwing any exception.
+	// An exception thrown while parsing (e.g., by a converter) is also returned in the result, and stops the parse.
+	TopionUtil::ParseResult topion_try_parse(int argc, char ** argv) noexcept{
+#ifdef TOPION_STATS
+		TopionStatsScope stats(*this);
+#endif // TOPION_STATS
+		topion_run(argc, argv);
+		return topion_result();
+	}
 
-		if(!parse_ended_midway){
-			// ------------------------------------------------------------
-			// Check the number of standalone parameters
-			// ------------------------------------------------------------
-			if(TOPION_STANDALONES.size() < TOPION_STANDALONE_MIN || TOPION_STANDALONES.size() > TOPION_STANDALONE_MAX){
+	template <class SINK>
+	TopionUtil::ParseResult topion_try_parse(int argc, char ** argv, SINK sink) noexcept{
+#ifdef TOPION_STATS
+		TopionStatsScope stats(*this);
+#endif // TOPION_STATS
+		topion_run(argc, argv, sink);
+		return topion_result();
+	}
+
+	// Parses a command line given as a string (e.g., received from a socket), without the program name.
+	// The line is split into the arguments by the quoting rules of the POSIX shell without any expansion (see TopionUtil::split_words)
+	// in a buffer of the instance, which the parsed strings refer to until the next topion_parse_line or topion_reset.
+	void topion_parse_line(TopionUtil::string_view line){
+#ifdef TOPION_STATS
+		TopionStatsScope stats(*this);
+#endif // TOPION_STATS
+		topion_run_line(line);
+		topion_throw_errors();
+	}
+
+	TopionUtil::ParseResult topion_try_parse_line(TopionUtil::string_view line) noexcept{
+#ifdef TOPION_STATS
+		TopionStatsScope stats(*this);
+#endif // TOPION_STATS
+		topion_run_line(line);
+		return topion_result();
+	}
+
+	// Restores all the variables to their default values and removes the standalone parameters
+	void topion_reset(){
+		const TopionUtil::Schema & schema = topion_schema();
+		for(auto it = schema.cases.begin(); it != schema.cases.end(); ++it){
+			if(it->assign == nullptr){
 				std::stringstream ss;
-				if(TOPION_STANDALONE_MAX == 0){
-					ss << "Standalone parameters cannot be accepted";
-				}else if(TOPION_STANDALONE_MIN == TOPION_STANDALONE_MAX){
-					if(TOPION_STANDALONE_MIN == 1){
-						ss << "Just 1 standalone parameter is required";
-					}else{
-						ss << "Just " << TOPION_STANDALONE_MIN << " standalone parameters are required";
-					}
-				}else if(TOPION_STANDALONE_MIN == 0){
-					ss << "At most " << TOPION_STANDALONE_MAX << " standalone parameters can be accepted";
-				}else if(TOPION_STANDALONE_MAX == std::numeric_limits<size_t>::max()){
-					if(TOPION_STANDALONE_MIN == 1){
-						ss << "At least 1 standalone parameter is required";
-					}else{
-						ss << "At least " << TOPION_STANDALONE_MIN << " standalone parameters are required";
-					}
+				if(!(it->name_long.empty())){
+					ss << "Switch \"--" << it->name_long << "\"";
 				}else{
-					ss << "Number of standalone parameters must be between " << TOPION_STANDALONE_MIN << " and " << TOPION_STANDALONE_MAX << std::endl;
+					ss << "Switch \"-" << it->name_short << "\"";
 				}
-				ss << " (specified " << TOPION_STANDALONES.size() << ").";
-				errors.push_back(ss.str());
+				ss << ": The type is not copy-assignable and cannot be reset.";
+				throw topion_definition_error(ss.str());
 			}
+			it->assign(topion_target(*it), reinterpret_cast<const char *>(schema.prototype) + it->offset);
+		}
 
-			// ------------------------------------------------------------
-			// Parse values
-			// ------------------------------------------------------------
-			for(auto it = specifications.begin(); it != specifications.end(); ++it){
-				TopionUtil::Case & c = TOPION_CASES[it->first];
-				if(!(c.conv(c.target, it->second))){
-					std::stringstream ss;
-					if(!(c.name_long.empty())){
-						ss << "Switch \"--" << c.name_long << "\"";
-					}else{
-						ss << "Switch \"-" << c.name_short << "\"";
-					}
-					ss << ": Value \"" << it->second << "\" is invalid for this switch.";
-					errors.push_back(ss.str());
-				}
+		TOPION_STANDALONES.clear();
+		TOPION_FILES.clear();
+		topion_clear_specifications(schema.cases.size());
+	}
+
+	// topion_reset + topion_parse: the instance can parse any number of command lines
+	void topion_reparse(int argc, char ** argv){
+		topion_reset();
+		topion_parse(argc, argv);
+	}
+
+	// Freezes the values of the switches and the standalone parameters into a flat image, which the same program
+	// (e.g., a worker process) can restore by topion_attach without parsing the command line again.
+	// The variables of PlainValue types are copied as they are (unless they have the default values),
+	// and the others as the parameters given by the last topion_parse.
+	std::vector<char> topion_snapshot() const{
+		const TopionUtil::Schema & schema = topion_schema();
+		std::vector<TopionUtil::SnapshotEntry> entries;
+		std::vector<const void *> sources;
+		std::uint64_t data = 0; // bytes of the data after the entries
+		for(size_t i = 0; i < schema.cases.size(); ++i){
+			const TopionUtil::Case & c = schema.cases[i];
+			if(c.plain_size == 0) continue;
+			if(schema.prototype && std::memcmp(topion_target(c), reinterpret_cast<const char *>(schema.prototype) + c.offset, c.plain_size) == 0) continue; // the default value
+			TopionUtil::SnapshotEntry e = {i, data, c.plain_size};
+			entries.push_back(e);
+			sources.push_back(topion_target(c));
+			data += topion_snapshot_align(c.plain_size);
+		}
+		for(auto it = TOPION_SPECIFIED.begin(); it != TOPION_SPECIFIED.end(); ++it){
+			if(schema.cases[it->case_id].plain_size != 0) continue;
+			TopionUtil::SnapshotEntry e = {it->case_id, data, std::strlen(it->value)};
+			entries.push_back(e);
+			sources.push_back(it->value);
+			data += topion_snapshot_align(e.length + 1);
+		}
+		size_t values = entries.size();
+		for(auto it = TOPION_STANDALONES.begin(); it != TOPION_STANDALONES.end(); ++it){
+			TopionUtil::SnapshotEntry e = {0, data, it->size()};
+			entries.push_back(e);
+			sources.push_back(it->data());
+			data += topion_snapshot_align(e.length + 1);
+		}
+
+		TopionUtil::SnapshotHeader header;
+		std::memcpy(header.magic, "TOPION", 7);
+		header.magic[7] = static_cast<char>(TopionUtil::snapshot_version);
+		header.layout = schema.layout;
+		header.values = values;
+		header.standalones = entries.size() - values;
+		size_t head = sizeof(header) + entries.size() * sizeof(TopionUtil::SnapshotEntry);
+		header.size = head + data;
+
+		std::vector<char> image(static_cast<size_t>(header.size), '\0');
+		std::memcpy(image.data(), &header, sizeof(header));
+		for(size_t i = 0; i < entries.size(); ++i){
+			entries[i].offset += head;
+			std::memcpy(image.data() + sizeof(header) + i * sizeof(TopionUtil::SnapshotEntry), &(entries[i]), sizeof(TopionUtil::SnapshotEntry));
+			std::memcpy(image.data() + entries[i].offset, sources[i], static_cast<size_t>(entries[i].length));
+		}
+		return image;
+	}
+
+	// Restores the values of the switches and the standalone parameters from a snapshot made by topion_snapshot,
+	// in the same way as topion_parse does from a command line. The strings (and the standalone parameters) refer to the snapshot
+	// without copying it, so the snapshot must be kept alive and unchanged as long as the struct is used.
+	void topion_attach(const void * image, size_t size){
+		const TopionUtil::Schema & schema = topion_schema();
+		const char * base = static_cast<const char *>(image);
+		TopionUtil::SnapshotHeader header;
+		if(size < sizeof(header)){
+			throw topion_parsing_error("The snapshot is broken.");
+		}
+		std::memcpy(&header, base, sizeof(header));
+		if(std::memcmp(header.magic, "TOPION", 7) != 0){
+			throw topion_parsing_error("The data is not a snapshot of Topion.");
+		}
+		if(header.magic[7] != static_cast<char>(TopionUtil::snapshot_version) || header.layout != schema.layout){
+			throw topion_definition_error("The snapshot was made by a program with different definitions of the switches.");
+		}
+		std::uint64_t capacity = (size - sizeof(header)) / sizeof(TopionUtil::SnapshotEntry);
+		if(header.size != size || header.values > capacity || header.standalones > capacity - header.values){
+			throw topion_parsing_error("The snapshot is broken.");
+		}
+
+		// Checks all the entries before changing anything
+		size_t values = static_cast<size_t>(header.values);
+		size_t num = values + static_cast<size_t>(header.standalones);
+		TopionUtil::SnapshotEntry e;
+		for(size_t i = 0; i < num; ++i){
+			std::memcpy(&e, base + sizeof(header) + i * sizeof(e), sizeof(e));
+			if(i < values && e.case_id >= schema.cases.size()) throw topion_parsing_error("The snapshot is broken.");
+			size_t plain_size = i < values ? schema.cases[static_cast<size_t>(e.case_id)].plain_size : 0;
+			bool valid;
+			if(plain_size != 0){
+				valid = e.length == plain_size && e.offset <= size - plain_size;
+			}else{
+				valid = e.offset < size && e.length < size - e.offset && base[e.offset + e.length] == '\0';
 			}
+			if(!valid) throw topion_parsing_error("The snapshot is broken.");
+		}
 
-			for(auto it = TOPION_MANDATORY.begin(); it != TOPION_MANDATORY.end(); ++it){
-				if(specifications.find(*it) == specifications.end()){
-					std::stringstream ss;
-					TopionUtil::Case & c = TOPION_CASES[*it];
-					if(!(c.name_long.empty())){
-						ss << "Switch \"--" << c.name_long << "\"";
-					}else{
-						ss << "Switch \"-" << c.name_short << "\"";
-					}
-					ss << " is mandatory but not specified.";
-					errors.push_back(ss.str());
-				}
+		topion_clear_specifications(schema.cases.size());
+		for(size_t i = 0; i < num; ++i){
+			std::memcpy(&e, base + sizeof(header) + i * sizeof(e), sizeof(e));
+			const char * p = base + e.offset;
+			if(i >= values){
+				TOPION_STANDALONES.emplace_back(p, static_cast<size_t>(e.length));
+				continue;
 			}
+			size_t case_id = static_cast<size_t>(e.case_id);
+			const TopionUtil::Case & c = schema.cases[case_id];
+			if(c.plain_size != 0){
+				std::memcpy(topion_target(c), p, c.plain_size);
+			}else{
+				TopionUtil::Specification s = {case_id, p, TopionUtil::npos};
+				TOPION_SPECIFIED.push_back(s);
+			}
+			TopionUtil::caseset_insert(TOPION_SEEN, case_id);
 		}
+		topion_convert_values();
+		topion_throw_errors();
+	}
 
-		// ------------------------------------------------------------
-		// Error occurred?
-		// ------------------------------------------------------------
-		if(!(errors.empty())){
-			std::stringstream ss;
-			if(errors.size() == 1){
-				ss << "An error found when parsing the command line: " << errors[0] << std::endl;
+	// The switches whose values differ from the ones in "before" (an instance of the same struct), as "--name" or "-c".
+	// The values copied as they are into snapshots (PlainValue) are compared, and the others by their parameters.
+	std::vector<std::string> topion_changes(const Topion & before) const{
+		const TopionUtil::Schema & schema = topion_schema();
+		if(&schema != &(before.topion_schema())){
+			throw topion_definition_error("Only the instances of the same struct can be compared.");
+		}
+		// The last parameter given to each switch
+		std::vector<const char *> values(schema.cases.size(), nullptr), before_values(schema.cases.size(), nullptr);
+		for(auto it = TOPION_SPECIFIED.begin(); it != TOPION_SPECIFIED.end(); ++it) values[it->case_id] = it->value;
+		for(auto it = before.TOPION_SPECIFIED.begin(); it != before.TOPION_SPECIFIED.end(); ++it) before_values[it->case_id] = it->value;
+
+		std::vector<std::string> changes;
+		for(size_t i = 0; i < schema.cases.size(); ++i){
+			const TopionUtil::Case & c = schema.cases[i];
+			bool changed;
+			if(c.plain_size > 0){
+				changed = std::memcmp(topion_target(c), before.topion_target(c), c.plain_size) != 0;
+			}else if(c.clear){
+				changed = !(topion_same_parameters(i, before));
 			}else{
-				ss << errors.size() << " errors found when parsing the command line:" << std::endl;
-				for(size_t i = 0; i < errors.size(); ++i){
-					ss << "(" << (i+1) << "/" << errors.size() << ") " << errors[i] << std::endl;
-				}
+				const char * a = values[i];
+				const char * b = before_values[i];
+				changed = (a == nullptr || b == nullptr) ? a != b : std::strcmp(a, b) != 0;
 			}
-			throw topion_parsing_error(ss.str());
+			if(changed) changes.push_back(c.name_long.empty() ? std::string("-") + c.name_short : "--" + c.name_long);
 		}
+		return changes;
 	}
 
-	const std::deque<std::string> & topion_standalones() const{
+	// The standalone parameters refer to the strings given to topion_parse (e.g., argv) without copying,
+	// so they are valid only while those strings are alive and unchanged.
+	const TopionUtil::buffer_type<TopionUtil::string_view> & topion_standalones() const{
 		return TOPION_STANDALONES;
 	}
 
-	typename std::deque<std::string>::size_type topion_standalone_size() const{
+	typename TopionUtil::buffer_type<TopionUtil::string_view>::size_type topion_standalone_size() const{
 		return TOPION_STANDALONES.size();
 	}
 
-	const std::string & operator[](typename std::deque<std::string>::size_type p) const{
+	TopionUtil::string_view operator[](typename TopionUtil::buffer_type<TopionUtil::string_view>::size_type p) const{
 		return TOPION_STANDALONES[p];
 	}
 
+#ifdef TOPION_STATS
+	// Statistics of the last topion_parse
+	const TopionUtil::ParseStats & topion_stats() const{
+		return TOPION_STATS_DATA;
+	}
+
+#endif // TOPION_STATS
+	// The definitions of the switches are shared by all the instances of the struct,
+	// so this detaches this instance from them, and frees the buffers reused by topion_parse.
+	// The standalone parameters and the variables may refer to TOPION_FILES and TOPION_LINE, which are kept.
 	void topion_release_parser(){
-		TOPION_CASES.clear();
-		TOPION_NAME2CASE.clear();
-		TOPION_MANDATORY.clear();
+		TOPION_SCHEMA.schema = nullptr;
+		TopionUtil::free_buffer(TOPION_SEEN);
+		TopionUtil::free_buffer(TOPION_LINE_ARGV);
+		TopionUtil::free_buffer(TOPION_SPECIFIED);
+		TopionUtil::free_buffer(TOPION_ERRORS);
+		TOPION_EXCEPTION = nullptr;
 	}
 };
 
-#define TOPION_ADD_O(    T, var,                                   desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, #T,        var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
-#define TOPION_ADD_OS(   T, var,             short,                desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, #T,        var, TopionUtil::Converter<T>(), #var, (short), (desc)}
-#define TOPION_ADD_OA(   T, var,                    argname,       desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, (argname), var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
-#define TOPION_ADD_OSA(  T, var,             short, argname,       desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, (argname), var, TopionUtil::Converter<T>(), #var, (short), (desc)}
-#define TOPION_ADD_OC(   T, var,                             CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, #T,        var, CONV, #var, '\0', (desc)}
-#define TOPION_ADD_OSC(  T, var,             short,          CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, #T,        var, CONV, #var, (short), (desc)}
-#define TOPION_ADD_OAC(  T, var,                    argname, CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, (argname), var, CONV, #var, '\0', (desc)}
-#define TOPION_ADD_OSAC( T, var,             short, argname, CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, (argname), var, CONV, #var, (short), (desc)}
-#define TOPION_ADD_OD(   T, var, defaultval,                       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, #T,        var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
-#define TOPION_ADD_ODS(  T, var, defaultval, short,                desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, #T,        var, TopionUtil::Converter<T>(), #var, (short), (desc)}
-#define TOPION_ADD_ODA(  T, var, defaultval,        argname,       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, (argname), var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
-#define TOPION_ADD_ODSA( T, var, defaultval, short, argname,       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, (argname), var, TopionUtil::Converter<T>(), #var, (short), (desc)}
-#define TOPION_ADD_ODC(  T, var, defaultval,                 CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, #T,        var, CONV, #var, '\0', (desc)}
-#define TOPION_ADD_ODSC( T, var, defaultval, short,          CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, #T,        var, CONV, #var, (short), (desc)}
-#define TOPION_ADD_ODAC( T, var, defaultval,        argname, CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, (argname), var, CONV, #var, '\0', (desc)}
-#define TOPION_ADD_ODSAC(T, var, defaultval, short, argname, CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, false, (argname), var, CONV, #var, (short), (desc)}
-#define TOPION_ADD_M(    T, var,                                   desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  #T,        var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
-#define TOPION_ADD_MS(   T, var,             short,                desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  #T,        var, TopionUtil::Converter<T>(), #var, (short), (desc)}
-#define TOPION_ADD_MA(   T, var,                    argname,       desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  (argname), var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
-#define TOPION_ADD_MSA(  T, var,             short, argname,       desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  (argname), var, TopionUtil::Converter<T>(), #var, (short), (desc)}
-#define TOPION_ADD_MC(   T, var,                             CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  #T,        var, CONV, #var, '\0', (desc)}
-#define TOPION_ADD_MSC(  T, var,             short,          CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  #T,        var, CONV, #var, (short), (desc)}
-#define TOPION_ADD_MAC(  T, var,                    argname, CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  (argname), var, CONV, #var, '\0', (desc)}
-#define TOPION_ADD_MSAC( T, var,             short, argname, CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  (argname), var, CONV, #var, (short), (desc)}
-#define TOPION_ADD_MD(   T, var, defaultval,                       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  #T,        var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
-#define TOPION_ADD_MDS(  T, var, defaultval, short,                desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  #T,        var, TopionUtil::Converter<T>(), #var, (short), (desc)}
-#define TOPION_ADD_MDA(  T, var, defaultval,        argname,       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  (argname), var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
-#define TOPION_ADD_MDSA( T, var, defaultval, short, argname,       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  (argname), var, TopionUtil::Converter<T>(), #var, (short), (desc)}
-#define TOPION_ADD_MDC(  T, var, defaultval,                 CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  #T,        var, CONV, #var, '\0', (desc)}
-#define TOPION_ADD_MDSC( T, var, defaultval, short,          CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  #T,        var, CONV, #var, (short), (desc)}
-#define TOPION_ADD_MDAC( T, var, defaultval,        argname, CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  (argname), var, CONV, #var, '\0', (desc)}
-#define TOPION_ADD_MDSAC(T, var, defaultval, short, argname, CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {TOPION_CASES, TOPION_NAME2CASE, TOPION_MANDATORY, true,  (argname), var, CONV, #var, (short), (desc)}
-
-#define TOPION_STANDALONE_ATLEAST(newmin, newargname) TopionUtil::StandaloneSetup TOPION_STANDALONE_SETUP = {TOPION_STANDALONE_MIN, TOPION_STANDALONE_MAX, TOPION_STANDALONE_ARGNAME, (newmin), std::numeric_limits<size_t>::max(), (newargname)};
-#define TOPION_STANDALONE_ATMOST(newmax, newargname) TopionUtil::StandaloneSetup TOPION_STANDALONE_SETUP = {TOPION_STANDALONE_MIN, TOPION_STANDALONE_MAX, TOPION_STANDALONE_ARGNAME, 0, (newmax), (newargname)};
-#define TOPION_STANDALONE_BETWEEN(newmin, newmax, newargname) TopionUtil::StandaloneSetup TOPION_STANDALONE_SETUP = {TOPION_STANDALONE_MIN, TOPION_STANDALONE_MAX, TOPION_STANDALONE_ARGNAME, (newmin), (newmax), (newargname)};
-#define TOPION_STANDALONE_JUST(newnum, newargname) TopionUtil::StandaloneSetup TOPION_STANDALONE_SETUP = {TOPION_STANDALONE_MIN, TOPION_STANDALONE_MAX, TOPION_STANDALONE_ARGNAME, (newnum), (newnum), (newargname)};
+// ------------------------------------------------------------
+// Batch parsing of manifests
+// ------------------------------------------------------------
+// Parses one command line of a manifest, adding the error (if any) to "errors"
+template <class OPTIONS>
+bool topion_parse_record(TopionUtil::Manifest & manifest, size_t record, OPTIONS & options, std::vector<char *> & argv, std::vector<TopionUtil::BatchError> & errors){
+	if(!manifest.split(record, argv)){
+		TopionUtil::BatchError e = {manifest.line(record), "An error found when parsing the command line: Quotation is not terminated.\n"};
+		errors.push_back(e);
+		return false;
+	}
+	TopionUtil::ParseResult result = options.topion_try_parse(static_cast<int>(argv.size() - 1), argv.data());
+	if(!result){
+		TopionUtil::BatchError e = {manifest.line(record), result.message()};
+		errors.push_back(e);
+		return false;
+	}
+	return true;
+}
+
+// Parses the command lines of the manifest by "threads" threads (0 for as many as the hardware threads) into one struct each "worker(id, record, errors)"
+template <class WORKER>
+void topion_run_manifest(TopionUtil::Manifest & manifest, unsigned threads, std::vector<TopionUtil::BatchError> & errors, WORKER worker){
+	unsigned workers = TopionUtil::worker_count(threads, manifest.size());
+	std::vector<std::vector<TopionUtil::BatchError>> found(workers);
+	TopionUtil::WorkQueue queue(manifest.size(), std::max<size_t>(1, std::min<size_t>(256, manifest.size() / (workers * 16))));
+	TopionUtil::run_workers(workers, [&](unsigned id){
+		worker(id, queue, found[id]);
+	});
+
+	errors.clear();
+	for(auto it = found.begin(); it != found.end(); ++it) errors.insert(errors.end(), it->begin(), it->end());
+	std::sort(errors.begin(), errors.end(), [](const TopionUtil::BatchError & a, const TopionUtil::BatchError & b){
+		return a.line < b.line;
+	});
+}
+
+// Parses each command line of the manifest into a struct, in parallel by "threads" threads (0 for as many as the hardware threads).
+// The structs are returned in the order of the lines, and the errors are stored into "errors" in the order of the lines
+// (the structs of the lines with errors are left as parsed halfway). The structs refer to the manifest.
+template <class OPTIONS>
+std::vector<OPTIONS> topion_parse_manifest(TopionUtil::Manifest & manifest, std::vector<TopionUtil::BatchError> & errors, unsigned threads = 0){
+	std::vector<OPTIONS> parsed(manifest.size());
+	topion_run_manifest(manifest, threads, errors, [&](unsigned, TopionUtil::WorkQueue & queue, std::vector<TopionUtil::BatchError> & found){
+		std::vector<char *> argv;
+		size_t first, last;
+		while(queue.next(first, last)){
+			for(size_t r = first; r < last; ++r) topion_parse_record(manifest, r, parsed[r], argv, found);
+		}
+	});
+	return parsed;
+}
+
+// Parses each command line of the manifest like above, but into one struct for each thread (reset before each line),
+// and calls "callback(line, OPTIONS &)" for each line parsed without errors. "callback" is called from the threads at the same time.
+template <class OPTIONS, class CALLBACK>
+void topion_parse_manifest(TopionUtil::Manifest & manifest, CALLBACK callback, std::vector<TopionUtil::BatchError> & errors, unsigned threads = 0){
+	topion_run_manifest(manifest, threads, errors, [&](unsigned, TopionUtil::WorkQueue & queue, std::vector<TopionUtil::BatchError> & found){
+		OPTIONS options;
+		std::vector<char *> argv;
+		size_t first, last;
+		while(queue.next(first, last)){
+			for(size_t r = first; r < last; ++r){
+				options.topion_reset();
+				if(topion_parse_record(manifest, r, options, argv, found)) callback(manifest.line(r), options);
+			}
+		}
+	});
+}
+
+// ------------------------------------------------------------
+// Live reload
+// ------------------------------------------------------------
+namespace TopionUtil{
+	// The parsed values of a struct replaced while the program runs (e.g., on SIGHUP), read by other threads without locks.
+	// Each reload parses into a new instance, which is published as a whole once parsed and never changed afterwards,
+	// so that a reader sees either the old values or the new ones. The old instance is freed after the readers reading it finish
+	// (an epoch counter and one slot per reader, on its own cache line).
+	template <class OPTIONS>
+	class Live{
+		// An instance of OPTIONS with the arguments it refers to
+		struct Version{
+			OPTIONS options;
+			std::vector<char> storage; // the arguments copied, each followed by a null character
+			std::shared_ptr<FileContent> file; // the control file
+			std::vector<char *> argv;
+		};
+
+		// The epoch being read by a reader (0 if not reading), kept apart from the other slots
+		struct Slot{
+			char before[64];
+			std::atomic<std::uint64_t> epoch;
+			char after[64];
+			bool used;
+		};
+
+	public:
+		class View;
+
+		// A thread reading the values. Constructed once for each thread, and destructed before the Live.
+		class Reader{
+		public:
+			explicit Reader(Live & live) : live(live), slot(live.acquire_slot()), depth(0) {}
+			~Reader(){
+				live.release_slot(slot);
+			}
+			Reader(const Reader &) = delete;
+			Reader & operator=(const Reader &) = delete;
+
+			// The current values, kept alive until the View is destructed (Views of a Reader can be nested)
+			View read(){
+				return View(*this);
+			}
+
+		private:
+			friend class View;
+			const OPTIONS * enter(){
+				if(depth++ == 0) slot->epoch.store(live.epoch.load());
+				return &(live.current.load()->options);
+			}
+			void leave(){
+				if(--depth == 0) slot->epoch.store(0, std::memory_order_release);
+			}
+
+			Live & live;
+			Slot * slot;
+			size_t depth;
+		};
+
+		class View{
+		public:
+			explicit View(Reader & reader) : reader(&reader), options(reader.enter()) {}
+			View(View && v) : reader(v.reader), options(v.options){
+				v.reader = nullptr;
+			}
+			~View(){
+				if(reader) reader->leave();
+			}
+			View(const View &) = delete;
+			View & operator=(const View &) = delete;
+
+			const OPTIONS & operator*() const{
+				return *options;
+			}
+			const OPTIONS * operator->() const{
+				return options;
+			}
+
+		private:
+			Reader * reader;
+			const OPTIONS * options;
+		};
+
+		// Starts with the default values
+		Live() : epoch(1), current(new Version()) {}
+		~Live(){
+			delete current.load();
+		}
+		Live(const Live &) = delete;
+		Live & operator=(const Live &) = delete;
+
+		// Parses the command line (copied) into a new instance and publishes it, returning the switches changed (see topion_changes).
+		// topion_parsing_error is thrown (and the current values are kept) if the command line has errors.
+		// Must not be called by a thread while it has a View.
+		std::vector<std::string> reload(int argc, char ** argv){
+			std::unique_ptr<Version> next(new Version());
+			size_t size = 0;
+			for(int i = 0; i < argc; ++i) size += std::strlen(argv[i]) + 1;
+			next->storage.resize(size);
+			char * p = next->storage.data();
+			for(int i = 0; i < argc; ++i){
+				size_t len = std::strlen(argv[i]) + 1;
+				std::memcpy(p, argv[i], len);
+				next->argv.push_back(p);
+				p += len;
+			}
+			return publish(std::move(next));
+		}
+
+		// Reloads from the control file, which lists the arguments (without the program name) in the same way as "@FILE"
+		// (one per line, or separated by null characters)
+		std::vector<std::string> reload_file(const char * path){
+			std::unique_ptr<Version> next(new Version());
+			next->file = FileContent::open(path);
+			if(!(next->file)){
+				std::stringstream ss;
+				ss << "An error found when parsing the command line: Cannot read the file of the arguments \"" << path << "\"." << std::endl;
+				throw topion_parsing_error(ss.str());
+			}
+			static char program[] = "";
+			next->argv.push_back(program);
+			FileArguments entries(*(next->file));
+			const char * entry;
+			while(entries.next(entry)) next->argv.push_back(const_cast<char *>(entry));
+			return publish(std::move(next));
+		}
+
+		// The values published last, for the thread reloading them (other threads read them through a Reader)
+		const OPTIONS & latest() const{
+			return current.load()->options;
+		}
+
+	private:
+		std::vector<std::string> publish(std::unique_ptr<Version> next){
+			next->argv.push_back(nullptr);
+			next->options.topion_parse(static_cast<int>(next->argv.size() - 1), next->argv.data());
+
+			std::lock_guard<std::mutex> lock(writer);
+			std::vector<std::string> changes = next->options.topion_changes(current.load()->options);
+			std::unique_ptr<Version> old(current.exchange(next.release()));
+			std::uint64_t e = ++epoch;
+
+			// Waits for the readers which may read the old instance
+			std::lock_guard<std::mutex> slots_lock(slots_mutex);
+			for(auto it = slots.begin(); it != slots.end(); ++it){
+				for(;;){
+					std::uint64_t reading = (*it)->epoch.load();
+					if(reading == 0 || reading >= e) break;
+					std::this_thread::yield();
+				}
+			}
+			return changes;
+		}
+
+		Slot * acquire_slot(){
+			std::lock_guard<std::mutex> lock(slots_mutex);
+			for(auto it = slots.begin(); it != slots.end(); ++it){
+				if(!((*it)->used)){
+					(*it)->used = true;
+					return it->get();
+				}
+			}
+			std::unique_ptr<Slot> s(new Slot());
+			s->epoch.store(0);
+			s->used = true;
+			slots.push_back(std::move(s));
+			return slots.back().get();
+		}
+
+		void release_slot(Slot * s){
+			std::lock_guard<std::mutex> lock(slots_mutex);
+			s->used = false;
+		}
+
+		std::atomic<std::uint64_t> epoch;
+		std::atomic<Version *> current;
+		std::mutex writer; // reloads one by one
+		std::mutex slots_mutex;
+		std::vector<std::unique_ptr<Slot>> slots;
+	};
+} // TopionUtil
+
+// ------------------------------------------------------------
+// Subcommands
+// ------------------------------------------------------------
+namespace TopionUtil{
+	// Subcommands of a program (e.g., "tool build ..." and "tool run ..."), each of which has its own struct.
+	// The struct of a subcommand is constructed (and its switches are registered) only when the subcommand is selected.
+	// GLOBAL is the struct of the switches before the name of the subcommand.
+	template <class GLOBAL>
+	class Subcommands{
+	public:
+		// Adds a subcommand, which parses the rest of the command line into OPTIONS and returns "handler(GLOBAL &, OPTIONS &)"
+		template <class OPTIONS, class HANDLER>
+		void add(const std::string & name, const std::string & description, HANDLER handler){
+			for(auto it = entries.begin(); it != entries.end(); ++it){
+				if(it->name == name){
+					std::stringstream ss;
+					ss << "Subcommand \"" << name << "\" is specified twice.";
+					throw topion_definition_error(ss.str());
+				}
+			}
+			Entry e;
+			e.name = name;
+			e.description = description;
+			e.run = [handler](GLOBAL & global, int argc, char ** argv) -> int{
+				OPTIONS options;
+				options.topion_parse(argc, argv);
+				return handler(global, options);
+			};
+			e.usage = &usage_of<OPTIONS>;
+			entries.push_back(e);
+			sealed = false;
+		}
+
+		// Parses the switches before the subcommand into "global", and the rest (from the name of the subcommand as argv[0])
+		// into the struct of the subcommand, and returns the value of the handler
+		int run(GLOBAL & global, int argc, char ** argv){
+			int head = global.topion_parse_head(argc, argv);
+			if(head >= argc){
+				throw topion_parsing_error("An error found when parsing the command line: Subcommand is required but not specified.\n");
+			}
+			size_t p = find(argv[head], std::strlen(argv[head]));
+			if(p == npos){
+				std::stringstream ss;
+				ss << "An error found when parsing the command line: Subcommand \"" << argv[head] << "\" is not defined." << std::endl;
+				throw topion_parsing_error(ss.str());
+			}
+			return entries[p].run(global, argc - head, argv + head);
+		}
+
+		int run(int argc, char ** argv){
+			GLOBAL global;
+			return run(global, argc, argv);
+		}
+
+		// Displays the usage of the switches before the subcommand, followed by the list of the subcommands
+		template <class IO>
+		void usage(IO & out, size_t display_width = 70, size_t tab_width = 20){
+			if(display_width <= tab_width){
+				throw topion_definition_error("For 'usage', 'display_width' must be larger than 'tab_width'");
+			}
+			std::string text = schema_of<GLOBAL>().usage(display_width, tab_width);
+			text += "Subcommands are:\n";
+			for(auto it = entries.begin(); it != entries.end(); ++it){
+				append_usage_entry(text, it->name + ":", it->description, display_width, tab_width);
+			}
+			out << text << std::flush;
+		}
+
+		// Displays the usage of a subcommand (false if it is not defined)
+		bool usage(std::ostream & out, const std::string & name, size_t display_width = 70, size_t tab_width = 20){
+			size_t p = find(name.data(), name.length());
+			if(p == npos) return false;
+			entries[p].usage(out, display_width, tab_width);
+			return true;
+		}
+
+		size_t size() const{
+			return entries.size();
+		}
+
+	private:
+		struct Entry{
+			std::string name;
+			std::string description;
+			std::function<int(GLOBAL &, int, char **)> run;
+			void (*usage)(std::ostream &, size_t, size_t);
+		};
+		std::vector<Entry> entries;
+		PerfectHash names;
+		bool sealed = false;
+
+		template <class OPTIONS>
+		static void usage_of(std::ostream & out, size_t display_width, size_t tab_width){
+			if(display_width <= tab_width){
+				throw topion_definition_error("For 'usage', 'display_width' must be larger than 'tab_width'");
+			}
+			out << schema_of<OPTIONS>().usage(display_width, tab_width) << std::flush;
+		}
+
+		// The subcommand of the name (npos if none), looked up by a perfect hash built after the subcommands are added
+		size_t find(const char * name, size_t len){
+			if(!sealed){
+				std::vector<PerfectHash::key_type> keys;
+				for(auto it = entries.begin(); it != entries.end(); ++it) keys.emplace_back(it->name.data(), it->name.length());
+				names.build(keys);
+				sealed = true;
+			}
+			size_t p = names.lookup(name, len);
+			if(p == npos) return npos;
+			const std::string & candidate = entries[p].name;
+			if(candidate.length() != len || std::memcmp(candidate.data(), name, len) != 0) return npos;
+			return p;
+		}
+	};
+} // TopionUtil
+
+#define TOPION_ADD_O(    T, var,                                   desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, #T,        var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
+#define TOPION_ADD_OS(   T, var,             short,                desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, #T,        var, TopionUtil::Converter<T>(), #var, (short), (desc)}
+#define TOPION_ADD_OA(   T, var,                    argname,       desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, (argname), var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
+#define TOPION_ADD_OSA(  T, var,             short, argname,       desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, (argname), var, TopionUtil::Converter<T>(), #var, (short), (desc)}
+#define TOPION_ADD_OC(   T, var,                             CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, #T,        var, CONV, #var, '\0', (desc)}
+#define TOPION_ADD_OSC(  T, var,             short,          CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, #T,        var, CONV, #var, (short), (desc)}
+#define TOPION_ADD_OAC(  T, var,                    argname, CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, (argname), var, CONV, #var, '\0', (desc)}
+#define TOPION_ADD_OSAC( T, var,             short, argname, CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, (argname), var, CONV, #var, (short), (desc)}
+#define TOPION_ADD_OD(   T, var, defaultval,                       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, #T,        var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
+#define TOPION_ADD_ODS(  T, var, defaultval, short,                desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, #T,        var, TopionUtil::Converter<T>(), #var, (short), (desc)}
+#define TOPION_ADD_ODA(  T, var, defaultval,        argname,       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, (argname), var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
+#define TOPION_ADD_ODSA( T, var, defaultval, short, argname,       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, (argname), var, TopionUtil::Converter<T>(), #var, (short), (desc)}
+#define TOPION_ADD_ODC(  T, var, defaultval,                 CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, #T,        var, CONV, #var, '\0', (desc)}
+#define TOPION_ADD_ODSC( T, var, defaultval, short,          CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, #T,        var, CONV, #var, (short), (desc)}
+#define TOPION_ADD_ODAC( T, var, defaultval,        argname, CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, (argname), var, CONV, #var, '\0', (desc)}
+#define TOPION_ADD_ODSAC(T, var, defaultval, short, argname, CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, false, (argname), var, CONV, #var, (short), (desc)}
+#define TOPION_ADD_M(    T, var,                                   desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  #T,        var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
+#define TOPION_ADD_MS(   T, var,             short,                desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  #T,        var, TopionUtil::Converter<T>(), #var, (short), (desc)}
+#define TOPION_ADD_MA(   T, var,                    argname,       desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  (argname), var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
+#define TOPION_ADD_MSA(  T, var,             short, argname,       desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  (argname), var, TopionUtil::Converter<T>(), #var, (short), (desc)}
+#define TOPION_ADD_MC(   T, var,                             CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  #T,        var, CONV, #var, '\0', (desc)}
+#define TOPION_ADD_MSC(  T, var,             short,          CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  #T,        var, CONV, #var, (short), (desc)}
+#define TOPION_ADD_MAC(  T, var,                    argname, CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  (argname), var, CONV, #var, '\0', (desc)}
+#define TOPION_ADD_MSAC( T, var,             short, argname, CONV, desc) T var = {};           TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  (argname), var, CONV, #var, (short), (desc)}
+#define TOPION_ADD_MD(   T, var, defaultval,                       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  #T,        var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
+#define TOPION_ADD_MDS(  T, var, defaultval, short,                desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  #T,        var, TopionUtil::Converter<T>(), #var, (short), (desc)}
+#define TOPION_ADD_MDA(  T, var, defaultval,        argname,       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  (argname), var, TopionUtil::Converter<T>(), #var, '\0', (desc)}
+#define TOPION_ADD_MDSA( T, var, defaultval, short, argname,       desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  (argname), var, TopionUtil::Converter<T>(), #var, (short), (desc)}
+#define TOPION_ADD_MDC(  T, var, defaultval,                 CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  #T,        var, CONV, #var, '\0', (desc)}
+#define TOPION_ADD_MDSC( T, var, defaultval, short,          CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  #T,        var, CONV, #var, (short), (desc)}
+#define TOPION_ADD_MDAC( T, var, defaultval,        argname, CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  (argname), var, CONV, #var, '\0', (desc)}
+#define TOPION_ADD_MDSAC(T, var, defaultval, short, argname, CONV, desc) T var = (defaultval); TopionUtil::CaseAddition<T> TOPION_CASE_##var = {this, TOPION_SCHEMA, true,  (argname), var, CONV, #var, (short), (desc)}
+
+#define TOPION_STANDALONE_ATLEAST(newmin, newargname) TopionUtil::StandaloneSetup TOPION_STANDALONE_SETUP = {this, TOPION_SCHEMA, (newmin), std::numeric_limits<size_t>::max(), (newargname)};
+#define TOPION_STANDALONE_ATMOST(newmax, newargname) TopionUtil::StandaloneSetup TOPION_STANDALONE_SETUP = {this, TOPION_SCHEMA, 0, (newmax), (newargname)};
+#define TOPION_STANDALONE_BETWEEN(newmin, newmax, newargname) TopionUtil::StandaloneSetup TOPION_STANDALONE_SETUP = {this, TOPION_SCHEMA, (newmin), (newmax), (newargname)};
+#define TOPION_STANDALONE_JUST(newnum, newargname) TopionUtil::StandaloneSetup TOPION_STANDALONE_SETUP = {this, TOPION_SCHEMA, (newnum), (newnum), (newargname)};
+
+#define TOPION_ACCEPT_RESPONSE_FILES() TopionUtil::ResponseFileSetup TOPION_RESPONSE_FILE_SETUP = {this, TOPION_SCHEMA};
+#define TOPION_ACCEPT_ABBREVIATIONS() TopionUtil::AbbreviationSetup TOPION_ABBREVIATION_SETUP = {this, TOPION_SCHEMA};
+
+#define TOPION_INDEPENDENT(var) TopionUtil::IndependenceSetup TOPION_INDEPENDENT_##var = {this, TOPION_SCHEMA, var, #var};
+#define TOPION_CONVERSION_THREADS(threads) TopionUtil::ConversionThreadSetup TOPION_CONVERSION_THREAD_SETUP = {this, TOPION_SCHEMA, (threads)};
+
+#define TOPION_EXPAND_GLOBS(threads) TopionUtil::GlobSetup TOPION_GLOB_SETUP = {this, TOPION_SCHEMA, (threads)};
+
+#if defined(TOPION_STATS) && defined(TOPION_STATS_ALLOCATIONS)
+// Replaces the global operators new and delete to count the heap allocations for TopionUtil::ParseStats.
+// Define TOPION_STATS_ALLOCATIONS in only one source file of the program (before including this file).
+// Every form is replaced, also the aligned ones which std::pmr::new_delete_resource uses, and all of them allocate with malloc
+// and release with free. They are not inlined, so the compiler does not pair the free with the caller's operator new.
+
+namespace TopionUtil{
+	inline void * counted_allocation(std::size_t size){
+		++allocation_count();
+		void * p = std::malloc(size == 0 ? 1 : size);
+		if(p == nullptr) throw std::bad_alloc();
+		return p;
+	}
+
+#if defined(__cpp_aligned_new)
+	// aligned_alloc wants the size to be a multiple of the alignment
+	inline void * counted_allocation(std::size_t size, std::align_val_t alignment){
+		++allocation_count();
+		std::size_t align = static_cast<std::size_t>(alignment);
+		void * p = std::aligned_alloc(align, size == 0 ? align : (size + align - 1) / align * align);
+		if(p == nullptr) throw std::bad_alloc();
+		return p;
+	}
+#endif
+}
+
+TOPION_NOINLINE void * operator new(std::size_t size){
+	return TopionUtil::counted_allocation(size);
+}
+
+TOPION_NOINLINE void * operator new[](std::size_t size){
+	return TopionUtil::counted_allocation(size);
+}
+
+TOPION_NOINLINE void operator delete(void * p) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete(void * p, std::size_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p, std::size_t) noexcept{
+	std::free(p);
+}
+
+#if defined(__cpp_aligned_new)
+TOPION_NOINLINE void * operator new(std::size_t size, std::align_val_t alignment){
+	return TopionUtil::counted_allocation(size, alignment);
+}
+
+TOPION_NOINLINE void * operator new[](std::size_t size, std::align_val_t alignment){
+	return TopionUtil::counted_allocation(size, alignment);
+}
+
+TOPION_NOINLINE void operator delete(void * p, std::align_val_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p, std::align_val_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete(void * p, std::size_t, std::align_val_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p, std::size_t, std::align_val_t) noexcept{
+	std::free(p);
+}
+#endif
+#endif // TOPION_STATS_ALLOCATIONS
 
 #endif // TOPION_HPP_
@@ -0,0 +1,831 @@
+// Benchmarks of Topion, run by "make bench".
+// Each result is printed as one JSON object per line, so that the results can be tracked over time:
+//   {"group": "...", "name": "...", "n": N, "iterations": I, "ns": T, "allocs": A, "bytes": B}
+// where "ns", "allocs" and "bytes" are per operation (one construction, one topion_parse, one conversion, ...),
+// and "n" is the size of the operation (the number of switches, arguments or elements).
+#include "topion.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// ------------------------------------------------------------
+// Allocation counting
+// ------------------------------------------------------------
+// Atomic for the benchmarks running threads (counted in relaxed order, which costs little more on one thread)
+static std::atomic<size_t> bench_allocations(0);
+static std::atomic<size_t> bench_allocated_bytes(0);
+
+// Every form is replaced: in C++17 the instance buffers come from std::pmr::new_delete_resource, which uses the aligned ones
+static void * bench_allocate(size_t size, size_t alignment){
+	bench_allocations.fetch_add(1, std::memory_order_relaxed);
+	bench_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+	void * p = nullptr;
+	if(alignment <= alignof(std::max_align_t)) p = std::malloc(size == 0 ? 1 : size);
+	else if(posix_memalign(&p, alignment, size) != 0) p = nullptr;
+	if(p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+TOPION_NOINLINE void * operator new(size_t size){
+	return bench_allocate(size, 0);
+}
+
+TOPION_NOINLINE void * operator new[](size_t size){
+	return bench_allocate(size, 0);
+}
+
+TOPION_NOINLINE void operator delete(void * p) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete(void * p, size_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p, size_t) noexcept{
+	std::free(p);
+}
+
+#if defined(__cpp_aligned_new)
+TOPION_NOINLINE void * operator new(size_t size, std::align_val_t alignment){
+	return bench_allocate(size, static_cast<size_t>(alignment));
+}
+
+TOPION_NOINLINE void * operator new[](size_t size, std::align_val_t alignment){
+	return bench_allocate(size, static_cast<size_t>(alignment));
+}
+
+TOPION_NOINLINE void operator delete(void * p, std::align_val_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p, std::align_val_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete(void * p, size_t, std::align_val_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p, size_t, std::align_val_t) noexcept{
+	std::free(p);
+}
+#endif
+
+// ------------------------------------------------------------
+// Measurement
+// ------------------------------------------------------------
+struct BenchOptions : public Topion{
+	TOPION_ADD_O(std::string, filter, "Run only the groups whose names contain this string");
+	TOPION_ADD_OD(double, scale, 1.0, "Multiplier of the number of iterations");
+};
+
+static BenchOptions bench_options;
+
+struct Result{
+	double ns;
+	double allocs;
+	double bytes;
+};
+
+// Keeps the optimizer from removing the measured code
+template <class T>
+void consume(const T & t){
+	asm volatile("" : : "r"(&t) : "memory");
+}
+
+size_t scaled(size_t iterations){
+	size_t n = static_cast<size_t>(iterations * bench_options.scale);
+	return n > 0 ? n : 1;
+}
+
+template <class F>
+Result measure(size_t iterations, F f){
+	size_t allocations = bench_allocations;
+	size_t bytes = bench_allocated_bytes;
+	auto start = std::chrono::steady_clock::now();
+	for(size_t i = 0; i < iterations; ++i) f();
+	auto end = std::chrono::steady_clock::now();
+	Result r;
+	r.ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+	r.allocs = static_cast<double>(bench_allocations - allocations) / iterations;
+	r.bytes = static_cast<double>(bench_allocated_bytes - bytes) / iterations;
+	return r;
+}
+
+// The result per one of "k" operations measured together
+Result divide(Result r, size_t k){
+	r.ns /= k;
+	r.allocs /= k;
+	r.bytes /= k;
+	return r;
+}
+
+bool enabled(const char * group){
+	return bench_options.filter.empty() || std::string(group).find(bench_options.filter) != std::string::npos;
+}
+
+void report(const char * group, const std::string & name, size_t n, size_t iterations, const Result & r){
+	char buf[512];
+	std::snprintf(buf, sizeof(buf), "{\"group\": \"%s\", \"name\": \"%s\", \"n\": %zu, \"iterations\": %zu, \"ns\": %.1f, \"allocs\": %.2f, \"bytes\": %.1f}",
+		group, name.c_str(), n, iterations, r.ns, r.allocs, r.bytes);
+	std::cout << buf << std::endl;
+}
+
+// Arguments built by the program, passed as argv
+class Argv{
+public:
+	Argv(){
+		add("bench");
+	}
+	void add(const std::string & s){
+		args.push_back(s);
+	}
+	int argc() const{
+		return static_cast<int>(args.size());
+	}
+	char ** argv(){
+		ptrs.clear();
+		for(auto & a : args) ptrs.push_back(&a[0]);
+		ptrs.push_back(nullptr);
+		return ptrs.data();
+	}
+private:
+	std::vector<std::string> args;
+	std::vector<char *> ptrs;
+};
+
+// ------------------------------------------------------------
+// Structs with many switches, generated by the preprocessor
+// ------------------------------------------------------------
+#define BENCH_O1(n) TOPION_ADD_OD(int, o##n, 0, "Generated switch");
+#define BENCH_O10(n) BENCH_O1(n##0) BENCH_O1(n##1) BENCH_O1(n##2) BENCH_O1(n##3) BENCH_O1(n##4) BENCH_O1(n##5) BENCH_O1(n##6) BENCH_O1(n##7) BENCH_O1(n##8) BENCH_O1(n##9)
+#define BENCH_O100(n) BENCH_O10(n##0) BENCH_O10(n##1) BENCH_O10(n##2) BENCH_O10(n##3) BENCH_O10(n##4) BENCH_O10(n##5) BENCH_O10(n##6) BENCH_O10(n##7) BENCH_O10(n##8) BENCH_O10(n##9)
+#define BENCH_O1000(n) BENCH_O100(n##0) BENCH_O100(n##1) BENCH_O100(n##2) BENCH_O100(n##3) BENCH_O100(n##4) BENCH_O100(n##5) BENCH_O100(n##6) BENCH_O100(n##7) BENCH_O100(n##8) BENCH_O100(n##9)
+
+// The switches are named "--o<first><digits>", e.g., "--o10" to "--o19" for Options10
+struct Options10 : public Topion{
+	using Topion::Topion;
+	BENCH_O10(1)
+};
+
+struct Options100 : public Topion{
+	BENCH_O100(1)
+};
+
+struct Options1000 : public Topion{
+	BENCH_O1000(1)
+};
+
+struct Options5000 : public Topion{
+	BENCH_O1000(1) BENCH_O1000(2) BENCH_O1000(3) BENCH_O1000(4) BENCH_O1000(5)
+};
+
+template <class OPTIONS>
+void bench_construction(const char * name, size_t switches, size_t iterations){
+	report("construct", std::string(name) + " (first)", switches, 1, measure(1, []{ OPTIONS o; consume(o); }));
+	iterations = scaled(iterations);
+	report("construct", name, switches, iterations, measure(iterations, []{ OPTIONS o; consume(o); }));
+}
+
+// ------------------------------------------------------------
+// topion_parse
+// ------------------------------------------------------------
+struct StandaloneOptions : public Topion{
+	TOPION_ADD_OS(bool, verbose, 'v', "Verbose");
+	TOPION_ADD_OD(int, jobs, 1, "Number of jobs");
+	TOPION_STANDALONE_ATLEAST(1, "FILES");
+};
+
+template <unsigned THREADS>
+struct GlobOptions : public Topion{
+	TOPION_STANDALONE_ATLEAST(1, "FILES");
+	TOPION_EXPAND_GLOBS(THREADS);
+};
+
+struct ValueOptions : public Topion{
+	TOPION_ADD_O(std::string, text, "Long string");
+	TOPION_ADD_O(TopionUtil::string_view, view, "Long string without copying");
+	TOPION_ADD_O(std::vector<int>, ids, "List of integers");
+	TOPION_ADD_O(std::vector<double>, weights, "List of real numbers");
+};
+
+// The lists of ValueOptions converted only when read
+struct LazyOptions : public Topion{
+	TOPION_ADD_OA(TopionUtil::Lazy<std::vector<int>>, ids, "LIST", "List of integers");
+	TOPION_ADD_OA(TopionUtil::Lazy<std::vector<double>>, weights, "LIST", "List of real numbers");
+};
+
+// A converter waiting for 1 ms like one loading a table from a file
+struct SlowConverter{
+	bool operator()(int & target, const char * s, size_t len) const{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return TopionUtil::Converter<int>()(target, s, len);
+	}
+};
+
+#define BENCH_SLOW_OPTIONS \
+	TOPION_ADD_OC(int, table1, SlowConverter(), "Slow switch"); \
+	TOPION_ADD_OC(int, table2, SlowConverter(), "Slow switch"); \
+	TOPION_ADD_OC(int, table3, SlowConverter(), "Slow switch"); \
+	TOPION_ADD_OC(int, table4, SlowConverter(), "Slow switch"); \
+	TOPION_ADD_OC(int, table5, SlowConverter(), "Slow switch"); \
+	TOPION_ADD_OC(int, table6, SlowConverter(), "Slow switch"); \
+	TOPION_ADD_OC(int, table7, SlowConverter(), "Slow switch"); \
+	TOPION_ADD_OC(int, table8, SlowConverter(), "Slow switch");
+
+struct SlowOptions : public Topion{
+	BENCH_SLOW_OPTIONS
+};
+
+// The same switches converted in parallel
+struct IndependentOptions : public Topion{
+	BENCH_SLOW_OPTIONS
+	TOPION_INDEPENDENT(table1);
+	TOPION_INDEPENDENT(table2);
+	TOPION_INDEPENDENT(table3);
+	TOPION_INDEPENDENT(table4);
+	TOPION_INDEPENDENT(table5);
+	TOPION_INDEPENDENT(table6);
+	TOPION_INDEPENDENT(table7);
+	TOPION_INDEPENDENT(table8);
+	TOPION_CONVERSION_THREADS(8);
+};
+
+// Set when a check of the benchmarks fails, so that "make bench" fails
+static bool bench_failed = false;
+
+// Parses the same command line repeatedly with one instance (topion_reparse) and with a new instance each time,
+// and restores the result from a snapshot (topion_attach).
+// (That a reparse allocates no memory is checked by topion_check, run by "make".)
+template <class OPTIONS>
+void bench_parse(const char * name, Argv & args, size_t n, size_t iterations){
+	iterations = scaled(iterations);
+	int argc = args.argc();
+	char ** argv = args.argv();
+	OPTIONS o;
+	o.topion_parse(argc, argv);
+	Result reparse = measure(iterations, [&]{
+		o.topion_reparse(argc, argv);
+		consume(o);
+	});
+	report("parse", std::string(name) + " (reparse)", n, iterations, reparse);
+	report("parse", std::string(name) + " (construct+parse)", n, iterations, measure(iterations, [&]{
+		OPTIONS p;
+		p.topion_parse(argc, argv);
+		consume(p);
+	}));
+
+	// Restoring the parsed values from a snapshot instead
+	std::vector<char> snapshot = o.topion_snapshot();
+	report("parse", std::string(name) + " (attach)", n, iterations, measure(iterations, [&]{
+		o.topion_reset();
+		o.topion_attach(snapshot.data(), snapshot.size());
+		consume(o);
+	}));
+}
+
+// Command lines with errors: the errors are all collected into the message of the exception
+template <class OPTIONS>
+void bench_parse_errors(const char * name, Argv & args, size_t n, size_t iterations){
+	iterations = scaled(iterations);
+	int argc = args.argc();
+	char ** argv = args.argv();
+	OPTIONS o;
+	report("parse", std::string(name) + " (errors)", n, iterations, measure(iterations, [&]{
+		try{
+			o.topion_reparse(argc, argv);
+		}catch(const topion_parsing_error & e){
+			consume(e);
+		}
+	}));
+	report("parse", std::string(name) + " (errors, try)", n, iterations, measure(iterations, [&]{
+		o.topion_reset();
+		TopionUtil::ParseResult r = o.topion_try_parse(argc, argv);
+		consume(r.errors().size());
+	}));
+}
+
+void bench_parses(){
+	{
+		Argv args;
+		for(int i = 1000; i < 2000; ++i) args.add("--o" + std::to_string(i) + "=" + std::to_string(i));
+		bench_parse<Options1000>("1000 switches", args, 1000, 200);
+	}
+	{
+		Argv args;
+		for(int i = 1000; i < 2000; i += 100) args.add("--o" + std::to_string(i) + "=" + std::to_string(i));
+		bench_parse<Options1000>("10 switches of 1000", args, 10, 2000);
+	}
+	{
+		Argv args;
+		args.add("-v");
+		args.add("--jobs=8");
+		for(int i = 0; i < 100000; ++i) args.add("file" + std::to_string(i) + ".txt");
+		bench_parse<StandaloneOptions>("100000 standalones", args, 100000, 20);
+
+		size_t count = 0;
+		StandaloneOptions o;
+		size_t iterations = scaled(20);
+		report("parse", "100000 standalones (sink)", 100000, iterations, measure(iterations, [&]{
+			o.topion_reset();
+			o.topion_parse(args.argc(), args.argv(), [&count](TopionUtil::string_view s){ count += s.size(); });
+		}));
+		consume(count);
+	}
+	{
+		Argv args;
+		args.add("--text=" + std::string(1 << 20, 'x'));
+		args.add("--view=" + std::string(1 << 20, 'y'));
+		bench_parse<ValueOptions>("2 values of 1MiB", args, 2, 200);
+	}
+	{
+		std::mt19937_64 rng(20240603);
+		std::string ids = "--ids=", weights = "--weights=";
+		char buf[64];
+		for(int i = 0; i < 100000; ++i){
+			if(i > 0){
+				ids += ',';
+				weights += ',';
+			}
+			ids += std::to_string(rng() % 1000000);
+			std::snprintf(buf, sizeof(buf), "%.4f", static_cast<double>(rng() % 10000000) / 10000);
+			weights += buf;
+		}
+		Argv args;
+		args.add(ids);
+		args.add(weights);
+		bench_parse<ValueOptions>("2 lists of 100000", args, 200000, 20);
+		bench_parse<LazyOptions>("2 lazy lists of 100000", args, 200000, 20);
+	}
+	{
+		Argv args;
+		for(int i = 1; i <= 8; ++i) args.add("--table" + std::to_string(i) + "=" + std::to_string(i));
+		bench_parse<SlowOptions>("8 converters of 1ms", args, 8, 20);
+		bench_parse<IndependentOptions>("8 independent converters of 1ms", args, 8, 20);
+
+		// One independent switch starts no threads
+		Argv one;
+		one.add("--table1=1");
+		bench_parse<IndependentOptions>("1 independent converter of 1ms", one, 1, 20);
+	}
+	{
+		Argv args;
+		for(int i = 100; i < 200; ++i) args.add("--o" + std::to_string(i) + "=x");
+		bench_parse_errors<Options100>("100 invalid values", args, 100, 200);
+	}
+	{
+		Argv args;
+		args.add("--undefined");
+		bench_parse_errors<Options100>("undefined switch", args, 1, 20000);
+	}
+	{
+		// A subcommand with 10 switches, among subcommands with 1000 and 5000 switches (which are never constructed)
+		TopionUtil::Subcommands<StandaloneOptions> tool;
+		tool.add<Options10>("small", "10 switches", [](StandaloneOptions &, Options10 & o){ consume(o); return 0; });
+		tool.add<Options1000>("large", "1000 switches", [](StandaloneOptions &, Options1000 & o){ consume(o); return 0; });
+		tool.add<Options5000>("huge", "5000 switches", [](StandaloneOptions &, Options5000 & o){ consume(o); return 0; });
+		Argv args;
+		args.add("-v");
+		args.add("small");
+		for(int i = 10; i < 20; ++i) args.add("--o" + std::to_string(i) + "=" + std::to_string(i));
+		size_t iterations = scaled(20000);
+		report("parse", "subcommand of 10 switches", 10, iterations, measure(iterations, [&]{
+			consume(tool.run(args.argc(), args.argv()));
+		}));
+	}
+	{
+		// A command line received as a string, split and parsed again by one instance
+		std::string line;
+		for(int i = 1000; i < 1010; ++i) line += "--o" + std::to_string(i) + "='" + std::to_string(i) + "' ";
+		Options1000 o;
+		o.topion_parse_line(line);
+		size_t iterations = scaled(20000);
+		Result r = measure(iterations, [&]{
+			o.topion_reset();
+			o.topion_parse_line(line);
+			consume(o);
+		});
+		report("parse", "line of 10 switches of 1000", 10, iterations, r);
+	}
+	{
+		// An instance for each request, whose buffers come from the heap or from an arena on the stack
+		std::string line;
+		for(int i = 10; i < 20; ++i) line += "--o" + std::to_string(i) + "=" + std::to_string(i) + " ";
+		size_t iterations = scaled(20000);
+		report("parse", "line of 10 per request", 10, iterations, measure(iterations, [&]{
+			Options10 o;
+			o.topion_parse_line(line);
+			consume(o);
+		}));
+		Result r = measure(iterations, [&]{
+			alignas(std::max_align_t) char buffer[4096];
+			TopionUtil::MonotonicArena arena(buffer, sizeof(buffer));
+			Options10 o(&arena);
+			o.topion_parse_line(line);
+			consume(o);
+		});
+		report("parse", "line of 10 per request in arena", 10, iterations, r);
+	}
+}
+
+// ------------------------------------------------------------
+// Manifests
+// ------------------------------------------------------------
+// A manifest of "lines" command lines like "prog -v --jobs=8 file0.txt file1.txt"
+std::string bench_manifest(size_t lines){
+	std::string text;
+	for(size_t i = 0; i < lines; ++i){
+		text += "prog -v --jobs=" + std::to_string(i % 64 + 1);
+		for(size_t k = 0; k < 4; ++k) text += " file" + std::to_string(i * 4 + k) + ".txt";
+		text += '\n';
+	}
+	return text;
+}
+
+void bench_batch(){
+	const size_t lines = 100000;
+	std::string text = bench_manifest(lines);
+	size_t iterations = scaled(5);
+	std::vector<TopionUtil::BatchError> errors;
+	std::vector<unsigned> counts(1, 1);
+	if(TopionUtil::worker_count(0, lines) > 1) counts.push_back(TopionUtil::worker_count(0, lines));
+	for(unsigned threads : counts){
+		std::string suffix = " (" + std::to_string(threads) + (threads == 1 ? " thread)" : " threads)");
+		report("batch", "100000 lines into structs" + suffix, lines, iterations, measure(iterations, [&]{
+			TopionUtil::Manifest manifest(text.data(), text.size());
+			std::vector<StandaloneOptions> parsed = topion_parse_manifest<StandaloneOptions>(manifest, errors, threads);
+			consume(parsed);
+		}));
+		std::atomic<size_t> jobs(0);
+		report("batch", "100000 lines to a callback" + suffix, lines, iterations, measure(iterations, [&]{
+			TopionUtil::Manifest manifest(text.data(), text.size());
+			topion_parse_manifest<StandaloneOptions>(manifest, [&jobs](size_t, StandaloneOptions & o){
+				jobs.fetch_add(static_cast<size_t>(o.jobs), std::memory_order_relaxed);
+			}, errors, threads);
+		}));
+		consume(jobs);
+	}
+}
+
+// ------------------------------------------------------------
+// Converters
+// ------------------------------------------------------------
+// The converters before the locale-independent parsing, for comparison
+bool legacy_long(long int * pi, const std::string & s){
+	char * ptr;
+	*pi = std::strtol(s.c_str(), &ptr, 10);
+	for(;;){
+		if(*ptr == '\0'){
+			return true;
+		}else if(std::isspace(*ptr)){
+			++ptr;
+		}else{
+			return false;
+		}
+	}
+}
+
+bool legacy_int(int * pi, const std::string & s){
+	long int li;
+	if(!legacy_long(&li, s)) return false;
+	*pi = static_cast<int>(li);
+	return static_cast<long int>(*pi) == li;
+}
+
+bool legacy_double(double * pd, const std::string & s){
+	char * ptr;
+	*pd = std::strtod(s.c_str(), &ptr);
+	return ptr == s.c_str() + s.length();
+}
+
+bool legacy_float(float * pf, const std::string & s){
+	double d;
+	if(!legacy_double(&d, s)) return false;
+	if(d <= std::numeric_limits<float>::lowest() || d >= std::numeric_limits<float>::max()) return false;
+	*pf = static_cast<float>(d);
+	return true;
+}
+
+// A custom CONV splitting the parameter by commas, as written before std::vector<T> is supported
+template <class T, class LEGACY>
+bool legacy_list(std::vector<T> * pv, const std::string & s, LEGACY legacy){
+	std::stringstream ss(s);
+	std::string element;
+	while(std::getline(ss, element, ',')){
+		T v;
+		if(!legacy(&v, element)) return false;
+		pv->push_back(v);
+	}
+	return true;
+}
+
+// Converts each of "inputs" by TopionUtil::Converter<T> (reported per conversion)
+template <class T>
+void bench_converter(const char * name, const std::vector<std::string> & inputs){
+	TopionUtil::Converter<T> conv;
+	size_t rounds = scaled(10);
+	report("convert", name, 1, rounds * inputs.size(), divide(measure(rounds, [&]{
+		for(auto & s : inputs){
+			T v = T();
+			conv(v, s.data(), s.length());
+			consume(v);
+		}
+	}), inputs.size()));
+}
+
+// Converts each of "inputs" by a converter object "conv"
+template <class T, class CONV>
+void bench_converter_object(const char * name, const CONV & conv, const std::vector<std::string> & inputs){
+	size_t rounds = scaled(10);
+	report("convert", name, 1, rounds * inputs.size(), divide(measure(rounds, [&]{
+		for(auto & s : inputs){
+			T v = T();
+			consume(conv(v, s.data(), s.length()));
+			consume(v);
+		}
+	}), inputs.size()));
+}
+
+enum class BenchMode{ read, write, scan, sync, stat, list, copy, move };
+
+const TopionUtil::ChoiceEntry<BenchMode> bench_modes[] = {
+	{"read", BenchMode::read}, {"write", BenchMode::write}, {"scan", BenchMode::scan}, {"sync", BenchMode::sync},
+	{"stat", BenchMode::stat}, {"list", BenchMode::list}, {"copy", BenchMode::copy}, {"move", BenchMode::move}};
+
+// Choices and ranges, compared with the converters written on top of Converter<T> (as in the samples)
+void bench_constraints(std::mt19937_64 & rng){
+	const size_t n = 100000;
+	const size_t num_modes = sizeof(bench_modes) / sizeof(bench_modes[0]);
+	std::vector<std::string> modes, bounded;
+	for(size_t i = 0; i < n; ++i){
+		modes.push_back(bench_modes[rng() % num_modes].name);
+		bounded.push_back(std::to_string(static_cast<int>(rng() % 1200) - 100));
+	}
+
+	TopionUtil::Choice<BenchMode> choice(bench_modes);
+	choice.prepare();
+	bench_converter_object<BenchMode>("choice of 8", choice, modes);
+	bench_converter_object<BenchMode>("choice of 8 (linear scan)", [num_modes](BenchMode & target, const char * s, size_t len){
+		for(size_t i = 0; i < num_modes; ++i){
+			if(std::strncmp(bench_modes[i].name, s, len) == 0 && bench_modes[i].name[len] == '\0'){
+				target = bench_modes[i].value;
+				return true;
+			}
+		}
+		return false;
+	}, modes);
+
+	bench_converter_object<int>("int in 1 to 1000", TopionUtil::Range<int>(1, 1000), bounded);
+	bench_converter_object<int>("int in 1 to 1000 (convert, then compare)", [](int & target, const char * s, size_t len){
+		return TopionUtil::Converter<int>()(target, s, len) && target >= 1 && target <= 1000;
+	}, bounded);
+}
+
+// The same for the previous converters; the results must be the same as TopionUtil::Converter<T> (otherwise the run fails)
+template <class T, class LEGACY>
+void bench_legacy_converter(const char * name, const std::vector<std::string> & inputs, LEGACY legacy){
+	TopionUtil::Converter<T> conv;
+	for(auto & s : inputs){
+		T a = T(), b = T();
+		if(conv(a, s.data(), s.length()) != legacy(&b, s) || a != b){
+			std::cerr << name << ": The result of \"" << s << "\" differs." << std::endl;
+			bench_failed = true;
+		}
+	}
+	size_t rounds = scaled(10);
+	report("convert", name, 1, rounds * inputs.size(), divide(measure(rounds, [&]{
+		for(auto & s : inputs){
+			T v = T();
+			legacy(&v, s);
+			consume(v);
+		}
+	}), inputs.size()));
+}
+
+// Converts a list of "elements" at once
+template <class T, class LEGACY>
+void bench_list(const char * name, const std::string & list, size_t elements, LEGACY legacy){
+	TopionUtil::Converter<std::vector<T>> conv;
+	std::vector<T> a, b;
+	if(!(conv(a, list.data(), list.length()) && legacy_list(&b, list, legacy) && a == b)){
+		std::cerr << name << ": The results differ." << std::endl;
+		bench_failed = true;
+	}
+	size_t rounds = scaled(20);
+	report("convert", std::string(name), elements, rounds, measure(rounds, [&]{
+		std::vector<T> v;
+		conv(v, list.data(), list.length());
+		consume(v);
+	}));
+	report("convert", std::string(name) + " (split+strto*)", elements, rounds, measure(rounds, [&]{
+		std::vector<T> v;
+		legacy_list(&v, list, legacy);
+		consume(v);
+	}));
+}
+
+void bench_converters(){
+	const size_t n = 100000;
+	std::mt19937_64 rng(20240601);
+	char buf[64];
+	std::vector<std::string> chars, shorts, ints, longs, long_longs, unsigneds, short_doubles, long_doubles, words;
+	for(size_t i = 0; i < n; ++i){
+		chars.push_back(std::string(1, static_cast<char>('a' + rng() % 26)));
+		shorts.push_back(std::to_string(static_cast<short>(rng())));
+		ints.push_back(std::to_string(static_cast<int>(rng())));
+		longs.push_back(std::to_string(static_cast<long int>(rng())));
+		long_longs.push_back(std::to_string(static_cast<long long int>(rng())));
+		unsigneds.push_back(std::to_string(rng()));
+		std::snprintf(buf, sizeof(buf), "%.3f", static_cast<double>(rng() % 100000000) / 1000);
+		short_doubles.push_back(buf);
+		std::snprintf(buf, sizeof(buf), "%.17g", std::ldexp(static_cast<double>(rng() >> 11), static_cast<int>(rng() % 200) - 153));
+		long_doubles.push_back(buf);
+		words.push_back(std::string(8 + rng() % 32, static_cast<char>('a' + rng() % 26)));
+	}
+
+	bench_converter<char>("char", chars);
+	bench_converter<short>("short", shorts);
+	bench_converter<unsigned short>("unsigned short", shorts);
+	bench_converter<int>("int", ints);
+	bench_legacy_converter<int>("int (strtol)", ints, legacy_int);
+	bench_converter<unsigned int>("unsigned int", ints);
+	bench_converter<long int>("long", longs);
+	bench_legacy_converter<long int>("long (strtol)", longs, legacy_long);
+	bench_converter<unsigned long int>("unsigned long", unsigneds);
+	bench_converter<long long int>("long long", long_longs);
+	bench_converter<unsigned long long int>("unsigned long long", unsigneds);
+	bench_converter<float>("float (%.3f)", short_doubles);
+	bench_legacy_converter<float>("float (%.3f, strtod)", short_doubles, legacy_float);
+	bench_converter<double>("double (%.3f)", short_doubles);
+	bench_legacy_converter<double>("double (%.3f, strtod)", short_doubles, legacy_double);
+	bench_converter<double>("double (%.17g)", long_doubles);
+	bench_legacy_converter<double>("double (%.17g, strtod)", long_doubles, legacy_double);
+	bench_converter<std::string>("std::string", words);
+	bench_converter<TopionUtil::string_view>("TopionUtil::string_view", words);
+	bench_converter<const char *>("const char *", words);
+	bench_constraints(rng);
+
+	std::string ids, long_ids, weights;
+	for(size_t i = 0; i < n; ++i){
+		if(i > 0){
+			ids += ',';
+			long_ids += ',';
+			weights += ',';
+		}
+		ids += std::to_string(rng() % 1000000);
+		long_ids += std::to_string(static_cast<long int>(rng()));
+		std::snprintf(buf, sizeof(buf), "%.4f", static_cast<double>(rng() % 10000000) / 10000);
+		weights += buf;
+	}
+	bench_list<int>("std::vector<int>", ids, n, legacy_int);
+	bench_list<long int>("std::vector<long>", long_ids, n, legacy_long);
+	bench_list<double>("std::vector<double>", weights, n, legacy_double);
+}
+
+// ------------------------------------------------------------
+// topion_usage
+// ------------------------------------------------------------
+template <class OPTIONS>
+void bench_usage(const char * name, size_t switches, size_t iterations){
+	iterations = scaled(iterations);
+	OPTIONS o;
+	std::ostringstream out;
+	report("usage", name, switches, iterations, measure(iterations, [&]{
+		out.str("");
+		o.topion_usage(out);
+		consume(out);
+	}));
+}
+
+// Reading the values published by TopionUtil::Live, and publishing new ones
+void bench_live(){
+	TopionUtil::Live<Options10> live;
+	Argv args;
+	for(int i = 10; i < 20; ++i) args.add("--o" + std::to_string(i) + "=" + std::to_string(i));
+	live.reload(args.argc(), args.argv());
+	{
+		TopionUtil::Live<Options10>::Reader reader(live);
+		size_t iterations = scaled(10000000);
+		report("live", "read", 1, iterations, measure(iterations, [&]{
+			TopionUtil::Live<Options10>::View v = reader.read();
+			consume(v->o15);
+		}));
+	}
+	size_t iterations = scaled(20000);
+	report("live", "reload 10 switches", 10, iterations, measure(iterations, [&]{
+		consume(live.reload(args.argc(), args.argv()));
+	}));
+}
+
+// Expanding a glob pattern matching 10000 files in 100 directories
+template <unsigned THREADS>
+void bench_glob_pattern(const char * name, Argv & args, size_t n, size_t iterations){
+	iterations = scaled(iterations);
+	GlobOptions<THREADS> o;
+	report("glob", std::string(name) + " (store)", n, iterations, measure(iterations, [&]{
+		o.topion_reset();
+		o.topion_parse(args.argc(), args.argv());
+		consume(o);
+	}));
+	size_t passed = 0;
+	report("glob", std::string(name) + " (sink)", n, iterations, measure(iterations, [&]{
+		o.topion_reset();
+		o.topion_parse(args.argc(), args.argv(), [&](TopionUtil::string_view s){ passed += s.size(); });
+		consume(passed);
+	}));
+}
+
+void bench_glob(){
+	char root[] = "/tmp/topion_bench_XXXXXX";
+	if(::mkdtemp(root) == nullptr){
+		std::cerr << "Cannot create a temporary directory for the glob benchmark." << std::endl;
+		bench_failed = true;
+		return;
+	}
+	const int dirs = 100, files = 100;
+	auto dir_path = [&](int d){ return std::string(root) + "/shard" + std::to_string(1000 + d); };
+	auto file_path = [&](int d, int f){ return dir_path(d) + "/part-" + std::to_string(10000 + f) + ".bin"; };
+	for(int d = 0; d < dirs; ++d){
+		::mkdir(dir_path(d).c_str(), 0700);
+		for(int f = 0; f < files; ++f){
+			std::FILE * fp = std::fopen(file_path(d, f).c_str(), "w");
+			if(fp) std::fclose(fp);
+		}
+	}
+
+	Argv args;
+	args.add(std::string(root) + "/shard*/part-*.bin");
+	bench_glob_pattern<1>("10000 paths, 1 thread", args, dirs * files, 20);
+	bench_glob_pattern<4>("10000 paths, 4 threads", args, dirs * files, 20);
+
+	for(int d = 0; d < dirs; ++d){
+		for(int f = 0; f < files; ++f) ::unlink(file_path(d, f).c_str());
+		::rmdir(dir_path(d).c_str());
+	}
+	::rmdir(root);
+}
+
+// The answers to the completion scripts ("--topion-complete WORD")
+void bench_completion(const char * word){
+	Options5000 o;
+	std::vector<std::string> candidates;
+	o.topion_complete(TopionUtil::string_view(word), candidates);
+	size_t n = candidates.size();
+	size_t iterations = scaled(20000);
+	report("complete", std::string("Options5000 ") + word, n, iterations, measure(iterations, [&]{
+		candidates.clear();
+		o.topion_complete(TopionUtil::string_view(word), candidates);
+		consume(candidates);
+	}));
+}
+
+int main(int argc, char ** argv){
+	try{
+		bench_options.topion_parse(argc, argv);
+	}catch(const topion_parsing_error & e){
+		std::cerr << e.what();
+		bench_options.topion_usage(std::cerr);
+		return 1;
+	}
+
+	if(enabled("construct")){
+		bench_construction<Options10>("Options10", 10, 100000);
+		bench_construction<Options100>("Options100", 100, 100000);
+		bench_construction<Options1000>("Options1000", 1000, 10000);
+		bench_construction<Options5000>("Options5000", 5000, 2000);
+	}
+	if(enabled("parse")) bench_parses();
+	if(enabled("batch")) bench_batch();
+	if(enabled("convert")) bench_converters();
+	if(enabled("live")) bench_live();
+	if(enabled("glob")) bench_glob();
+	if(enabled("complete")){
+		bench_completion("--o1234");
+		bench_completion("--o123");
+		bench_completion("--o12");
+	}
+	if(enabled("usage")){
+		bench_usage<Options10>("Options10", 10, 10000);
+		bench_usage<Options100>("Options100", 100, 1000);
+		bench_usage<Options1000>("Options1000", 1000, 100);
+		bench_usage<Options5000>("Options5000", 5000, 20);
+	}
+	return bench_failed ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+// Checks of Topion, built and run by "make": the parses that must not allocate memory.
+// Each check parses once (so that the buffers of the instance are allocated), then parses again several times
+// counting the heap allocations, and the program fails (exits with 1) if any of them allocates.
+#include "topion.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// ------------------------------------------------------------
+// Allocation counting
+// ------------------------------------------------------------
+static size_t check_allocations = 0;
+
+static void * check_allocate(size_t size, size_t alignment){
+	++check_allocations;
+	void * p = nullptr;
+	if(alignment <= alignof(std::max_align_t)) p = std::malloc(size == 0 ? 1 : size);
+	else if(posix_memalign(&p, alignment, size) != 0) p = nullptr;
+	if(p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+TOPION_NOINLINE void * operator new(size_t size){
+	return check_allocate(size, 0);
+}
+
+TOPION_NOINLINE void * operator new[](size_t size){
+	return check_allocate(size, 0);
+}
+
+TOPION_NOINLINE void operator delete(void * p) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete(void * p, size_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p, size_t) noexcept{
+	std::free(p);
+}
+
+#if defined(__cpp_aligned_new)
+TOPION_NOINLINE void * operator new(size_t size, std::align_val_t alignment){
+	return check_allocate(size, static_cast<size_t>(alignment));
+}
+
+TOPION_NOINLINE void * operator new[](size_t size, std::align_val_t alignment){
+	return check_allocate(size, static_cast<size_t>(alignment));
+}
+
+TOPION_NOINLINE void operator delete(void * p, std::align_val_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p, std::align_val_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete(void * p, size_t, std::align_val_t) noexcept{
+	std::free(p);
+}
+
+TOPION_NOINLINE void operator delete[](void * p, size_t, std::align_val_t) noexcept{
+	std::free(p);
+}
+#endif
+
+// ------------------------------------------------------------
+// Checks
+// ------------------------------------------------------------
+static bool check_failed = false;
+
+// Runs "f" once, and then "f" several times, which must not allocate
+template <class F>
+void check_no_allocation(const char * name, F f){
+	f();
+	size_t before = check_allocations;
+	for(int i = 0; i < 10; ++i) f();
+	size_t allocations = check_allocations - before;
+	if(allocations != 0){
+		std::cerr << name << ": allocated memory " << allocations << " times in 10 parses." << std::endl;
+		check_failed = true;
+	}else{
+		std::cout << name << ": OK" << std::endl;
+	}
+}
+
+// Arguments built by the program, passed as argv
+class Argv{
+public:
+	Argv(){
+		add("check");
+	}
+	void add(const std::string & s){
+		args.push_back(s);
+	}
+	int argc() const{
+		return static_cast<int>(args.size());
+	}
+	char ** argv(){
+		ptrs.clear();
+		for(auto & a : args) ptrs.push_back(&a[0]);
+		ptrs.push_back(nullptr);
+		return ptrs.data();
+	}
+private:
+	std::vector<std::string> args;
+	std::vector<char *> ptrs;
+};
+
+struct Options : public Topion{
+	using Topion::Topion;
+	TOPION_ADD_OS(bool, verbose, 'v', "Verbose");
+	TOPION_ADD_OD(int, jobs, 1, "Number of jobs");
+	TOPION_ADD_O(double, ratio, "Ratio");
+	TOPION_ADD_O(std::string, name, "Name");
+	TOPION_ADD_O(TopionUtil::string_view, view, "Name without copying");
+	TOPION_ADD_O(std::vector<int>, ids, "List of integers");
+	TOPION_STANDALONE_ATLEAST(0, "FILES");
+};
+
+struct LazyOptions : public Topion{
+	TOPION_ADD_OA(TopionUtil::Lazy<std::vector<int>>, ids, "LIST", "List of integers");
+};
+
+// One independent switch is converted by the calling thread, starting no threads
+struct IndependentOptions : public Topion{
+	TOPION_ADD_O(int, table1, "Table");
+	TOPION_ADD_O(int, table2, "Table");
+	TOPION_INDEPENDENT(table1);
+	TOPION_INDEPENDENT(table2);
+};
+
+int main(){
+	Argv args;
+	args.add("-v");
+	args.add("--jobs=8");
+	args.add("--ratio=0.25");
+	args.add("--name=a name longer than the small string buffer");
+	args.add("--view=another name longer than the small string buffer");
+	args.add("--ids=1,2,3,4,5,6,7,8,9,10");
+	for(int i = 0; i < 100; ++i) args.add("file" + std::to_string(i) + ".txt");
+	int argc = args.argc();
+	char ** argv = args.argv();
+
+	Options o;
+	check_no_allocation("reparse", [&]{
+		o.topion_reparse(argc, argv);
+	});
+
+	Argv wrong;
+	wrong.add("--jobs=x");
+	wrong.add("--undefined");
+	Options e;
+	check_no_allocation("reparse with errors", [&]{
+		e.topion_reset();
+		e.topion_try_parse(wrong.argc(), wrong.argv());
+	});
+
+	std::string line = "-v --jobs=8 --name='a name longer than the small string buffer' --ids=1,2,3 file0.txt file1.txt";
+	Options l;
+	check_no_allocation("line reparse", [&]{
+		l.topion_reset();
+		l.topion_parse_line(line);
+	});
+
+	// A new instance for each parse, whose buffers come from an arena on the stack
+	// (the variables themselves are not, so the line has no strings or lists to be copied)
+	std::string request = "-v --jobs=8 --ratio=0.25 --view='a name longer than the small string buffer' file0.txt file1.txt";
+	check_no_allocation("new instance in arena", [&]{
+		alignas(std::max_align_t) char buffer[8192];
+		TopionUtil::MonotonicArena arena(buffer, sizeof(buffer));
+		Options a(&arena);
+		a.topion_parse_line(request);
+	});
+
+	Argv lazy;
+	lazy.add("--ids=1,2,3,4,5,6,7,8,9,10");
+	LazyOptions z;
+	check_no_allocation("reparse of a Lazy", [&]{
+		z.topion_reparse(lazy.argc(), lazy.argv());
+	});
+
+	Argv one;
+	one.add("--table1=1");
+	IndependentOptions t;
+	check_no_allocation("reparse of one independent switch", [&]{
+		t.topion_reparse(one.argc(), one.argv());
+	});
+
+	return check_failed ? 1 : 0;
+}
@@ -7,9 +7,9 @@ struct CharSwitch{
 	const char * candidates;
 	CharSwitch(const char * cand) : candidates(cand) {}
 
-	bool operator()(void * target, const std::string & s) const{
-		if(s.length() != 1) return false;
-		*(static_cast<char *>(target)) = s[0];
+	bool operator()(char & target, const char * s, size_t len) const{
+		if(len != 1) return false;
+		target = s[0];
 
 		const char * c = candidates;
 		while(*c != '\0'){
@@ -27,9 +27,9 @@ struct RangeSwitch{
 	T minval, maxval;
 	RangeSwitch(const T & a, const T & b) : minval(a), maxval(b) {}
 
-	bool operator()(void * target, const std::string & s) const{
-		if(!(TopionUtil::Converter<T>()(target, s))) return false;
-		if(*(static_cast<T *>(target)) < minval || *(static_cast<T *>(target)) > maxval) return false;
+	bool operator()(T & target, const char * s, size_t len) const{
+		if(!(TopionUtil::Converter<T>()(target, s, len))) return false;
+		if(target < minval || target > maxval) return false;
 		return true;
 	}
 };